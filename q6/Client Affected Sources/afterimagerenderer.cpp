@@ -0,0 +1,46 @@
+#include "afterimagerenderer.h"
+#include "creature.h"
+#include "map.h"
+#include "tile.h"
+
+#include <framework/core/clock.h>
+
+// Global instance of the afterimage renderer
+AfterimageRenderer g_afterimages;
+
+// Registers a creature that just pushed new afterimages into its ring
+void AfterimageRenderer::addEmitter(const CreaturePtr& creature)
+{
+    if (std::find(m_emitters.begin(), m_emitters.end(), creature) == m_emitters.end())
+        m_emitters.push_back(creature);
+}
+
+// Samples the frame time and forgets creatures whose afterimages all faded out
+void AfterimageRenderer::update()
+{
+    m_now = g_clock.millis();
+    m_emitters.erase(std::remove_if(m_emitters.begin(), m_emitters.end(), [this](const CreaturePtr& creature) {
+        return !creature->getAfterimages().hasLive(m_now);
+    }), m_emitters.end());
+}
+
+// Draws every live afterimage of a floor, floorOrigin being the screen position of x = 0, y = 0 on that floor
+void AfterimageRenderer::draw(int z, const Point& floorOrigin, int tileSize, float scaleFactor)
+{
+    for (const CreaturePtr& creature : m_emitters) {
+        const AfterimageRing& ring = creature->getAfterimages();
+        for (int i = 0; i < ring.size(); ++i) {
+            const Afterimage& afterimage = ring.at(i);
+            if (afterimage.position.z != z || afterimage.isExpired(m_now))
+                continue;
+
+            int elevation = 0;
+            if (const TilePtr& tile = g_map.getTile(afterimage.position))
+                elevation = tile->getDrawElevation();
+
+            Point dest = floorOrigin + Point(afterimage.position.x, afterimage.position.y) * tileSize +
+                         (afterimage.offset - Point(elevation, elevation)) * scaleFactor;
+            creature->drawAfterimage(dest, scaleFactor, afterimage, m_now);
+        }
+    }
+}
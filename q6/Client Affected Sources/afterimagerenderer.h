@@ -0,0 +1,82 @@
+#ifndef AFTERIMAGERENDERER_H
+#define AFTERIMAGERENDERER_H
+
+#include "declarations.h"
+
+struct Afterimage
+{
+    Position position;
+    Point offset;
+    int xPattern;
+    int zPattern;
+    int animationPhase;
+    ticks_t startTime;
+    float duration;
+
+    bool isExpired(ticks_t now) const { return now - startTime >= duration; }
+    float getOpacity(ticks_t now) const { return 1.0f - std::max<float>(0.0f, std::min<float>((now - startTime) / duration, 1.0f)); }
+};
+
+/**
+ * Fixed capacity ring of afterimages. New afterimages overwrite the oldest
+ * ones once the ring is full, and expired entries are skipped by timestamp,
+ * so nothing is ever erased or reallocated.
+ */
+class AfterimageRing
+{
+public:
+    enum {
+        CAPACITY = 16
+    };
+
+    AfterimageRing() : m_head(0), m_size(0) { }
+
+    void push(const Afterimage& afterimage) {
+        m_items[(m_head + m_size) % CAPACITY] = afterimage;
+        if (m_size < CAPACITY)
+            m_size++;
+        else
+            m_head = (m_head + 1) % CAPACITY;
+    }
+
+    bool hasLive(ticks_t now) const {
+        for (int i = 0; i < m_size; ++i) {
+            if (!at(i).isExpired(now))
+                return true;
+        }
+        return false;
+    }
+
+    int size() const { return m_size; }
+    const Afterimage& at(int i) const { return m_items[(m_head + i) % CAPACITY]; }
+    void clear() { m_head = m_size = 0; }
+
+private:
+    std::array<Afterimage, CAPACITY> m_items;
+    int m_head;
+    int m_size;
+};
+
+/**
+ * Keeps the creatures that have live afterimages and draws all of them in
+ * one pass per floor, instead of routing every afterimage through the tile
+ * it lies on.
+ */
+class AfterimageRenderer
+{
+public:
+    void addEmitter(const CreaturePtr& creature);
+    void update();
+    void draw(int z, const Point& floorOrigin, int tileSize, float scaleFactor);
+
+    bool isEmpty() { return m_emitters.empty(); }
+    void clear() { m_emitters.clear(); }
+
+private:
+    std::vector<CreaturePtr> m_emitters;
+    ticks_t m_now = 0;
+};
+
+extern AfterimageRenderer g_afterimages;
+
+#endif
@@ -0,0 +1,341 @@
+#include "commandbufferpainter.h"
+
+// Constructor for the CommandBufferPainter class
+CommandBufferPainter::CommandBufferPainter()
+    : m_target(nullptr), m_layer(0), m_blendEquation(BlendEquation_Add), m_alphaWriting(false),
+      m_stateChanges(0), m_stateChangesSkipped(0)
+{
+    m_shaderProgram = nullptr;
+    m_compositionMode = CompositionMode_Normal;
+    m_color = Color::white;
+    m_opacity = 1.0f;
+}
+
+// Starts recording for a target. Color, opacity, clip and composition are taken from the target,
+// the rest of the state is expected to be at its reset value.
+void CommandBufferPainter::begin(Painter *target)
+{
+    m_target = target;
+    m_commands.clear();
+    m_savedStates.clear();
+    m_layerOrders.clear();
+    m_layer = 0;
+    m_shaderProgram = nullptr;
+    m_compositionMode = target->getCompositionMode();
+    m_blendEquation = BlendEquation_Add;
+    m_alphaWriting = false;
+    m_clipRect = target->getClipRect();
+    m_color = target->getColor();
+    m_opacity = target->getOpacity();
+    m_resolution = target->getResolution();
+    m_stateChanges = m_stateChangesSkipped = 0;
+}
+
+// Sorts the recorded commands and replays them onto the target
+void CommandBufferPainter::flush()
+{
+    if (!m_target || m_commands.empty())
+        return;
+
+    sortCommands();
+
+    DrawState applied;
+    bool known = false;
+    for (const Command& command : m_commands) {
+        applyState(command.state, applied, known);
+        switch (command.type) {
+            case Command_TexturedRect:
+                m_target->drawTexturedRect(command.dest, command.texture, command.src);
+                break;
+            case Command_FilledRect:
+                m_target->drawFilledRect(command.dest);
+                break;
+            case Command_Draw:
+                command.call(m_target);
+                break;
+            case Command_StateCall:
+                // The call may restore any state on the target, so the next command sets everything again
+                command.call(m_target);
+                known = false;
+                break;
+        }
+    }
+
+    // Leave the target with the state the recording ended with
+    DrawState state = getState();
+    applyState(state, applied, known);
+    m_commands.clear();
+}
+
+// Selects the layer key of the next commands and how the quads inside that layer may be reordered
+void CommandBufferPainter::setLayer(int layer, LayerOrder order)
+{
+    m_layer = layer;
+    if (order != LayerOrder_Recorded)
+        m_layerOrders[layer] = order;
+    else
+        m_layerOrders.erase(layer);
+}
+
+void CommandBufferPainter::saveState()
+{
+    m_savedStates.push_back(getState());
+    recordStateCall([](Painter *target) { target->saveState(); });
+}
+
+void CommandBufferPainter::saveAndResetState()
+{
+    m_savedStates.push_back(getState());
+    m_shaderProgram = nullptr;
+    m_compositionMode = CompositionMode_Normal;
+    m_blendEquation = BlendEquation_Add;
+    m_alphaWriting = false;
+    m_clipRect = Rect();
+    m_color = Color::white;
+    m_opacity = 1.0f;
+    recordStateCall([](Painter *target) { target->saveAndResetState(); });
+}
+
+void CommandBufferPainter::restoreSavedState()
+{
+    if (m_savedStates.empty())
+        return;
+
+    const DrawState& state = m_savedStates.back();
+    m_shaderProgram = state.shaderProgram;
+    m_compositionMode = state.compositionMode;
+    m_blendEquation = state.blendEquation;
+    m_alphaWriting = state.alphaWriting;
+    m_clipRect = state.clipRect;
+    m_color = state.color;
+    m_opacity = state.opacity;
+    m_savedStates.pop_back();
+    recordStateCall([](Painter *target) { target->restoreSavedState(); });
+}
+
+void CommandBufferPainter::clear(const Color& color)
+{
+    record(Command_Draw, Rect(), Rect(), nullptr, [color](Painter *target) { target->clear(color); });
+}
+
+// Coords buffers are owned by the caller, so everything recorded so far is replayed and they are drawn right away
+void CommandBufferPainter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
+{
+    flush();
+    if (m_target)
+        m_target->drawCoords(coordsBuffer, drawMode);
+}
+
+void CommandBufferPainter::drawFillCoords(CoordsBuffer& coordsBuffer)
+{
+    flush();
+    if (m_target)
+        m_target->drawFillCoords(coordsBuffer);
+}
+
+void CommandBufferPainter::drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture)
+{
+    flush();
+    if (m_target)
+        m_target->drawTextureCoords(coordsBuffer, texture);
+}
+
+void CommandBufferPainter::drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    if (dest.isEmpty() || src.isEmpty() || !texture)
+        return;
+    record(Command_TexturedRect, dest, src, texture, nullptr);
+}
+
+void CommandBufferPainter::drawUpsideDownTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    record(Command_Draw, dest, src, texture, [dest, texture, src](Painter *target) { target->drawUpsideDownTexturedRect(dest, texture, src); });
+}
+
+void CommandBufferPainter::drawRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    record(Command_Draw, dest, src, texture, [dest, texture, src](Painter *target) { target->drawRepeatedTexturedRect(dest, texture, src); });
+}
+
+void CommandBufferPainter::drawFilledRect(const Rect& dest)
+{
+    if (dest.isEmpty())
+        return;
+    record(Command_FilledRect, dest, Rect(), nullptr, nullptr);
+}
+
+void CommandBufferPainter::drawFilledTriangle(const Point& a, const Point& b, const Point& c)
+{
+    record(Command_Draw, Rect(), Rect(), nullptr, [a, b, c](Painter *target) { target->drawFilledTriangle(a, b, c); });
+}
+
+void CommandBufferPainter::drawBoundingRect(const Rect& dest, int innerLineWidth)
+{
+    record(Command_Draw, dest, Rect(), nullptr, [dest, innerLineWidth](Painter *target) { target->drawBoundingRect(dest, innerLineWidth); });
+}
+
+void CommandBufferPainter::setResolution(const Size& resolution)
+{
+    m_resolution = resolution;
+    recordStateCall([resolution](Painter *target) { target->setResolution(resolution); });
+}
+
+void CommandBufferPainter::scale(float x, float y)
+{
+    recordStateCall([x, y](Painter *target) { target->scale(x, y); });
+}
+
+void CommandBufferPainter::translate(float x, float y)
+{
+    recordStateCall([x, y](Painter *target) { target->translate(x, y); });
+}
+
+void CommandBufferPainter::rotate(float angle)
+{
+    recordStateCall([angle](Painter *target) { target->rotate(angle); });
+}
+
+void CommandBufferPainter::rotate(float x, float y, float angle)
+{
+    recordStateCall([x, y, angle](Painter *target) { target->rotate(x, y, angle); });
+}
+
+void CommandBufferPainter::pushTransformMatrix()
+{
+    recordStateCall([](Painter *target) { target->pushTransformMatrix(); });
+}
+
+void CommandBufferPainter::popTransformMatrix()
+{
+    recordStateCall([](Painter *target) { target->popTransformMatrix(); });
+}
+
+// Describes the recorded commands, one per line
+std::string CommandBufferPainter::dump()
+{
+    static const char *typeNames[] = { "texturedRect", "filledRect", "draw", "stateCall" };
+
+    std::stringstream ss;
+    for (size_t i = 0; i < m_commands.size(); ++i) {
+        const Command& command = m_commands[i];
+        ss << i << ": " << typeNames[command.type] << " layer=" << command.layer;
+        if (command.type != Command_StateCall) {
+            ss << " program=" << command.state.shaderProgram << " texture=" << (command.texture ? command.texture->getId() : 0)
+               << " composition=" << command.state.compositionMode << " blend=" << command.state.blendEquation
+               << " opacity=" << command.state.opacity << " dest=" << command.dest;
+        }
+        ss << "\n";
+    }
+    return ss.str();
+}
+
+CommandBufferPainter::DrawState CommandBufferPainter::getState()
+{
+    return DrawState{m_shaderProgram, m_compositionMode, m_blendEquation, m_clipRect, m_color, m_opacity, m_alphaWriting};
+}
+
+void CommandBufferPainter::record(CommandType type, const Rect& dest, const Rect& src, const TexturePtr& texture, const std::function<void(Painter*)>& call)
+{
+    if (!m_target)
+        return;
+    m_commands.push_back(Command{type, m_layer, getState(), dest, src, texture, call});
+}
+
+void CommandBufferPainter::recordStateCall(const std::function<void(Painter*)>& call)
+{
+    record(Command_StateCall, Rect(), Rect(), nullptr, call);
+}
+
+// Batches every run of quads that shares a layer ordered by state
+void CommandBufferPainter::sortCommands()
+{
+    size_t begin = 0;
+    while (begin < m_commands.size()) {
+        const Command& first = m_commands[begin];
+        size_t end = begin + 1;
+        auto orderIt = m_layerOrders.find(first.layer);
+        if (isSortable(first) && orderIt != m_layerOrders.end() && orderIt->second == LayerOrder_ByState) {
+            while (end < m_commands.size() && isSortable(m_commands[end]) && m_commands[end].layer == first.layer)
+                ++end;
+            batchCommands(begin, end);
+        }
+        begin = end;
+    }
+}
+
+// Moves each quad back to the latest batch with its render state, as long as it overlaps none of the quads it passes.
+// States are only compared for equality, so the order never depends on where textures or programs live in memory.
+void CommandBufferPainter::batchCommands(size_t begin, size_t end)
+{
+    m_batches.clear();
+    m_batchNext.assign(end - begin, -1);
+
+    for (int i = 0; i < (int)(end - begin); ++i) {
+        const Command& command = m_commands[begin + i];
+        bool placed = false;
+        for (int b = (int)m_batches.size() - 1; b >= 0; --b) {
+            Batch& batch = m_batches[b];
+            if (hasSameState(m_commands[begin + batch.head], command)) {
+                m_batchNext[batch.tail] = i;
+                batch.tail = i;
+                batch.bounds = batch.bounds.united(command.dest);
+                placed = true;
+                break;
+            }
+
+            // Passing a batch is only allowed when the quad covers none of its quads
+            if (!batch.bounds.intersects(command.dest))
+                continue;
+            bool overlaps = false;
+            for (int j = batch.head; j >= 0 && !overlaps; j = m_batchNext[j])
+                overlaps = m_commands[begin + j].dest.intersects(command.dest);
+            if (overlaps)
+                break;
+        }
+        if (!placed)
+            m_batches.push_back(Batch{i, i, command.dest});
+    }
+
+    if (m_batches.size() == end - begin)
+        return;
+
+    m_batchedCommands.clear();
+    for (const Batch& batch : m_batches) {
+        for (int j = batch.head; j >= 0; j = m_batchNext[j])
+            m_batchedCommands.push_back(std::move(m_commands[begin + j]));
+    }
+    std::move(m_batchedCommands.begin(), m_batchedCommands.end(), m_commands.begin() + begin);
+    m_batchedCommands.clear();
+}
+
+// Checks if two quads can be drawn in one batch, color and opacity travel with every quad
+bool CommandBufferPainter::hasSameState(const Command& a, const Command& b)
+{
+    return a.type == b.type && a.texture == b.texture && a.state.shaderProgram == b.state.shaderProgram &&
+           a.state.compositionMode == b.state.compositionMode && a.state.blendEquation == b.state.blendEquation &&
+           a.state.alphaWriting == b.state.alphaWriting && a.state.clipRect == b.state.clipRect;
+}
+
+// Sets on the target only the parts of the state that differ from what it already has
+void CommandBufferPainter::applyState(const DrawState& state, DrawState& applied, bool& known)
+{
+    auto change = [&](bool differs, auto&& set) {
+        if (known && !differs) {
+            m_stateChangesSkipped++;
+            return;
+        }
+        set();
+        m_stateChanges++;
+    };
+
+    change(state.shaderProgram != applied.shaderProgram, [&] { m_target->setShaderProgram(state.shaderProgram); });
+    change(state.compositionMode != applied.compositionMode, [&] { m_target->setCompositionMode(state.compositionMode); });
+    change(state.blendEquation != applied.blendEquation, [&] { m_target->setBlendEquation(state.blendEquation); });
+    change(state.alphaWriting != applied.alphaWriting, [&] { m_target->setAlphaWriting(state.alphaWriting); });
+    change(state.clipRect != applied.clipRect, [&] { m_target->setClipRect(state.clipRect); });
+    change(state.color != applied.color, [&] { m_target->setColor(state.color); });
+    change(state.opacity != applied.opacity, [&] { m_target->setOpacity(state.opacity); });
+
+    applied = state;
+    known = true;
+}
@@ -0,0 +1,125 @@
+#ifndef COMMANDBUFFERPAINTER_H
+#define COMMANDBUFFERPAINTER_H
+
+#include "painter.h"
+
+/**
+ * Painter that records draws into a command buffer instead of issuing GL.
+ * Every command carries the full render state it was recorded with and a
+ * layer key. On flush, runs of quads inside layers ordered by state are
+ * gathered into batches sharing render state, a quad only moving back past
+ * quads it does not overlap, so the result matches the recorded order.
+ * Then everything is replayed onto the target painter, setting only the
+ * state that differs from the previous command. Draws from coords buffers are not copied: the
+ * buffer is flushed and they go straight to the target.
+ */
+class CommandBufferPainter : public Painter
+{
+public:
+    enum CommandType {
+        Command_TexturedRect,
+        Command_FilledRect,
+        Command_Draw,
+        Command_StateCall
+    };
+    // How the quads of a layer may be reordered on flush
+    enum LayerOrder {
+        LayerOrder_Recorded,
+        LayerOrder_ByState
+    };
+    struct DrawState {
+        PainterShaderProgram *shaderProgram;
+        CompositionMode compositionMode;
+        BlendEquation blendEquation;
+        Rect clipRect;
+        Color color;
+        float opacity;
+        bool alphaWriting;
+    };
+    struct Command {
+        CommandType type;
+        int layer;
+        DrawState state;
+        Rect dest;
+        Rect src;
+        TexturePtr texture;
+        std::function<void(Painter*)> call;
+    };
+
+    CommandBufferPainter();
+
+    void begin(Painter *target);
+    void flush();
+    void setLayer(int layer, LayerOrder order = LayerOrder_Recorded);
+
+    void saveState();
+    void saveAndResetState();
+    void restoreSavedState();
+
+    void clear(const Color& color);
+
+    void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = Triangles);
+    void drawFillCoords(CoordsBuffer& coordsBuffer);
+    void drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture);
+    void drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+    void drawUpsideDownTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+    void drawRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+    void drawFilledRect(const Rect& dest);
+    void drawFilledTriangle(const Point& a, const Point& b, const Point& c);
+    void drawBoundingRect(const Rect& dest, int innerLineWidth = 1);
+
+    void setTexture(Texture *texture) { }
+    void setClipRect(const Rect& clipRect) { m_clipRect = clipRect; }
+    void setAlphaWriting(bool enable) { m_alphaWriting = enable; }
+    void setBlendEquation(BlendEquation blendEquation) { m_blendEquation = blendEquation; }
+    void setCompositionMode(CompositionMode compositionMode) { m_compositionMode = compositionMode; }
+    void setResolution(const Size& resolution);
+
+    void scale(float x, float y);
+    void translate(float x, float y);
+    void rotate(float angle);
+    void rotate(float x, float y, float angle);
+    void pushTransformMatrix();
+    void popTransformMatrix();
+
+    bool hasShaders() { return m_target && m_target->hasShaders(); }
+    bool canBatchTexturedRects() { return m_target && m_target->canBatchTexturedRects(); }
+
+    const std::vector<Command>& getCommands() { return m_commands; }
+    int getStateChanges() { return m_stateChanges; }
+    int getStateChangesSkipped() { return m_stateChangesSkipped; }
+    std::string dump();
+
+private:
+    DrawState getState();
+    void record(CommandType type, const Rect& dest, const Rect& src, const TexturePtr& texture, const std::function<void(Painter*)>& call);
+    void recordStateCall(const std::function<void(Painter*)>& call);
+    void sortCommands();
+    void batchCommands(size_t begin, size_t end);
+    void applyState(const DrawState& state, DrawState& applied, bool& known);
+
+    static bool isSortable(const Command& command) { return command.type == Command_TexturedRect || command.type == Command_FilledRect; }
+    static bool hasSameState(const Command& a, const Command& b);
+
+    // Quads sharing render state, chained through m_batchNext in recorded order
+    struct Batch {
+        int head;
+        int tail;
+        Rect bounds;
+    };
+
+    Painter *m_target;
+    std::vector<Command> m_commands;
+    std::vector<DrawState> m_savedStates;
+    std::unordered_map<int, LayerOrder> m_layerOrders;
+    std::vector<Batch> m_batches;
+    std::vector<int> m_batchNext;
+    std::vector<Command> m_batchedCommands;
+    int m_layer;
+    BlendEquation m_blendEquation;
+    bool m_alphaWriting;
+    int m_stateChanges;
+    int m_stateChangesSkipped;
+};
+
+#endif
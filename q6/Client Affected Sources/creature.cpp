@@ -9,6 +9,17 @@
 #include "luavaluecasts.h"
 #include "lightview.h"
 #include "uimap.h"
+#include "walkingcreatureindex.h"
+#include "walkanimator.h"
+#include "timeline.h"
+#include "textbatcher.h"
+#include "outlinecache.h"
+#include "emitterregistry.h"
+#include "outfitcache.h"
+#include "outfitcolorizer.h"
+#include "afterimagerenderer.h"
+#include "spriteatlas.h"
+#include "stepduration.h"
 
 #include <framework/graphics/graphics.h>
 #include <framework/core/eventdispatcher.h>
@@ -21,12 +32,25 @@
 #include <framework/ui/uimanager.h>
 #include "spritemanager.h"
 
+// Outfit color uniforms of the colorize program
+static const Painter::UniformHandle HEAD_COLOR_UNIFORM = Painter::declareUniform("u_HeadColor");
+static const Painter::UniformHandle BODY_COLOR_UNIFORM = Painter::declareUniform("u_BodyColor");
+static const Painter::UniformHandle LEGS_COLOR_UNIFORM = Painter::declareUniform("u_LegsColor");
+static const Painter::UniformHandle FEET_COLOR_UNIFORM = Painter::declareUniform("u_FeetColor");
+
 Creature::Creature() : Thing()
 {
     // Initialize creature attributes with default values
     initializeAttributes();
 }
 
+Creature::~Creature()
+{
+    // The walking index and the emitter registry do not own their creatures, so a dying creature leaves them
+    if (m_walking) g_walkingCreatures.removeLeavingCreature(m_lastStepFromPosition, this);
+    g_emitters.removeEmitter(this);
+}
+
 void Creature::initializeAttributes()
 {
     // Set default values for creature attributes
@@ -43,13 +67,18 @@ void Creature::initializeAttributes()
     m_type = Proto::CreatureTypeUnknown;
     m_icon = Otc::NpcIconNone;
     m_lastStepDirection = Otc::InvalidDirection;
-    m_nameCache.setFont(g_fonts.getFont("verdana-11px-rounded"));
-    m_nameCache.setAlign(Fw::AlignTopCenter);
+    m_nameFont = g_fonts.getFont("verdana-11px-rounded");
+    m_nameRun = g_glyphRuns.get(m_nameFont, m_name);
     m_footStep = 0;
     m_speedFormula.fill(-1);
+    m_cachedStepDuration.fill(-1);
+    m_cachedStepGroundRevision = 0;
     m_outfitColor = Color::white;
     m_isDashing = false;
-    m_afterimagesClearTimer = Timer();
+    m_outfitColorTween = 0;
+    m_shieldBlinkTween = 0;
+    m_timedSquareTween = 0;
+    m_jumpTween = 0;
 }
 
 void Creature::preDraw(const Point& dest, float scaleFactor, bool animate, LightView* lightView)
@@ -88,6 +117,20 @@ int Creature::calculateXPattern() const
     }
 }
 
+void Creature::startDash()
+{
+    // Only steps taken from now on leave afterimages
+    m_isDashing = true;
+    m_lastPosition = m_position;
+    g_emitters.addEmitter(this);
+}
+
+void Creature::endDash()
+{
+    m_isDashing = false;
+    g_emitters.removeEmitter(this);
+}
+
 void Creature::updateAfterimages(int zPattern, int xPattern)
 {
     // If the creature has moved, update the afterimages for dashing effect
@@ -96,9 +139,11 @@ void Creature::updateAfterimages(int zPattern, int xPattern)
             // Calculate offset for afterimages based on movement direction
             Point direction = m_lastPosition - m_position;
             Point offset = direction * (Otc::TILE_PIXELS / 2);
-            // Create afterimages at current and last positions
-            m_afterimages.emplace_back(LocalEffect::Afterimage(m_position, offset, xPattern, zPattern, 0, 400.0f));
-            m_afterimages.emplace_back(LocalEffect::Afterimage(m_lastPosition, Point(0, 0), xPattern, zPattern, 0, 350.0f));
+            // Create afterimages at current and last positions, the ring overwrites the oldest ones
+            ticks_t now = g_clock.millis();
+            m_afterimages.push(Afterimage{m_position, offset, xPattern, zPattern, 0, now, 400.0f});
+            m_afterimages.push(Afterimage{m_lastPosition, Point(0, 0), xPattern, zPattern, 0, now, 350.0f});
+            g_afterimages.addEmitter(static_self_cast<Creature>());
         }
         m_lastPosition = m_position; // Update last position
     }
@@ -204,6 +249,39 @@ void Creature::drawCreatureOutfit(Point dest, float scaleFactor, bool animateWal
     // Determine the animation phase for the outfit
     int animationPhase = determineAnimationPhase(animateWalk, animateIdle);
     int xPattern = calculateXPattern();
+
+    // Draw a cached composite when nothing per-draw (dash outline, color fade, jump) alters the frame
+    if (!isDashing() && m_outfitColor == Color::white && m_jumpOffset.isNull() && canUseOutfitCache()) {
+        OutfitFrameKey key;
+        key.lookType = m_outfit.getId();
+        key.mount = m_outfit.getMount();
+        key.head = m_outfit.getHead();
+        key.body = m_outfit.getBody();
+        key.legs = m_outfit.getLegs();
+        key.feet = m_outfit.getFeet();
+        key.addons = m_outfit.getAddons();
+        key.xPattern = xPattern;
+        key.animationPhase = animationPhase;
+
+        bool drawn = g_outfitCache.draw(key, dest, scaleFactor, [&](const Point& cellDest) {
+            drawOutfitComposite(cellDest, 1.0f, xPattern, animationPhase, nullptr);
+        });
+        if (drawn) return;
+    }
+
+    drawOutfitComposite(dest, scaleFactor, xPattern, animationPhase, lightView);
+}
+
+bool Creature::canUseOutfitCache()
+{
+    // The outfit drawn over its mount must fit into a cache cell as a whole
+    ThingType* mountType = m_outfit.getMount() != 0 ? g_things.rawGetThingType(m_outfit.getMount(), ThingCategoryCreature) : nullptr;
+    return g_outfitCache.canCache(rawGetThingType(), mountType);
+}
+
+void Creature::drawOutfitComposite(Point dest, float scaleFactor, int xPattern, int animationPhase, LightView* lightView)
+{
+    // Draw the mount first, it also determines the Z pattern of the outfit
     int zPattern = calculateZPatternForMount(dest, scaleFactor);
 
     // Adjust destination for jump offset
@@ -246,7 +324,10 @@ int Creature::calculateZPatternForMount(Point& dest, float scaleFactor) const
     if (m_outfit.getMount() != 0) {
         auto datType = g_things.rawGetThingType(m_outfit.getMount(), ThingCategoryCreature);
         dest -= datType->getDisplacement() * scaleFactor;
-        datType->draw(dest, scaleFactor, 0, calculateXPattern(), 0, 0, determineAnimationPhase(false, false), nullptr);
+        int xPattern = calculateXPattern();
+        int animationPhase = determineAnimationPhase(false, false);
+        if (!g_spriteAtlas.drawThing(datType, dest, scaleFactor, 0, xPattern, 0, 0, animationPhase))
+            datType->draw(dest, scaleFactor, 0, xPattern, 0, 0, animationPhase, nullptr);
         dest += getDisplacement() * scaleFactor;
         return std::min<int>(1, getNumPatternZ() - 1);
     }
@@ -256,27 +337,26 @@ int Creature::calculateZPatternForMount(Point& dest, float scaleFactor) const
 
 void Creature::applyDashEffect(const std::shared_ptr<ThingType>& datType, Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase, LightView* lightView)
 {
-    // Apply a visual effect for dashing creatures
-    if (isDashing()) {
-        g_painter->setBrushConfiguration(BrushConfiguration("u_IsDashing", 1));
-        g_painter->flushBrushConfigurations(Painter::PaintType_Creature);
-
-        datType->draw(dest, scaleFactor, 0, xPattern, yPattern, zPattern, animationPhase, yPattern == 0 ? lightView : nullptr);
-
-        g_painter->setBrushConfiguration(BrushConfiguration("u_IsDashing", 0));
-        g_painter->flushBrushConfigurations(Painter::PaintType_Creature);
-    }
+    // Highlight dashing creatures with their precomputed outline, drawn behind the outfit
+    if (isDashing())
+        g_outlines.draw(datType.get(), dest, scaleFactor, xPattern, yPattern, zPattern, animationPhase, Color::red);
 }
 
 void Creature::drawOutfitLayers(const std::shared_ptr<ThingType>& datType, Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase)
 {
-    // Draw the base layer of the outfit
-    datType->draw(dest, scaleFactor, 0, xPattern, yPattern, zPattern, animationPhase, nullptr);
+    // Colorize head, body, legs and feet in a single shader pass when the painter supports it
+    if (drawColorizedLayer(datType.get(), dest, scaleFactor, xPattern, yPattern, zPattern, animationPhase)) {
+        return;
+    }
+
+    // Draw the base layer of the outfit, from the sprite atlas when all of its sprites could be packed
+    if (!g_spriteAtlas.drawThing(datType.get(), dest, scaleFactor, 0, xPattern, yPattern, zPattern, animationPhase))
+        datType->draw(dest, scaleFactor, 0, xPattern, yPattern, zPattern, animationPhase, nullptr);
 
     // Draw additional layers with color if the outfit has multiple layers
     if (getLayers() > 1) {
-        Color oldColor = g_painter->getColor();
-        Painter::CompositionMode oldComposition = g_painter->getCompositionMode();
+        // Save the painter state, the restore only re-applies the color and composition mode changed below
+        g_painter->saveState();
         g_painter->setCompositionMode(Painter::CompositionMode_Multiply);
 
         // Draw each layer with its respective color
@@ -290,11 +370,35 @@ void Creature::drawOutfitLayers(const std::shared_ptr<ThingType>& datType, Point
         datType->draw(dest, scaleFactor, SpriteMaskBlue, xPattern, yPattern, zPattern, animationPhase);
 
         // Restore previous color and composition mode
-        g_painter->setColor(oldColor);
-        g_painter->setCompositionMode(oldComposition);
+        g_painter->restoreSavedState();
     }
 }
 
+bool Creature::drawColorizedLayer(ThingType* datType, const Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase)
+{
+    if (!g_outfitColorizer.canColorize(datType)) {
+        return false;
+    }
+
+    // Fetch the untrimmed base and mask textures of the frame
+    const OutfitColorizer::Frame& frame = g_outfitColorizer.getFrame(datType, xPattern, yPattern, zPattern, animationPhase);
+    Size frameSize = datType->getSize() * Otc::TILE_PIXELS;
+    Point frameOffset = (datType->getSize().toPoint() - Point(1, 1)) * Otc::TILE_PIXELS + datType->getDisplacement();
+    Rect screenRect(dest - frameOffset * scaleFactor, frameSize * scaleFactor);
+
+    // Upload the outfit colors and draw base and masks as one quad
+    g_painter->applyPaintType(Painter::PaintType_Creature);
+    g_painter->setOutfitMaskTexture(frame.mask);
+    g_painter->setUniform(HEAD_COLOR_UNIFORM, m_outfit.getHeadColor());
+    g_painter->setUniform(BODY_COLOR_UNIFORM, m_outfit.getBodyColor());
+    g_painter->setUniform(LEGS_COLOR_UNIFORM, m_outfit.getLegsColor());
+    g_painter->setUniform(FEET_COLOR_UNIFORM, m_outfit.getFeetColor());
+    g_painter->flushBrushConfigurations(Painter::PaintType_Creature);
+    g_painter->drawTexturedRect(screenRect, frame.base, Rect(Point(0, 0), frameSize));
+    g_painter->setOutfitMaskTexture(nullptr);
+    return true;
+}
+
 void Creature::drawNonCreatureOutfit(Point dest, float scaleFactor, bool animateIdle, LightView* lightView)
 {
     // Draw non-creature outfits such as items or effects
@@ -323,18 +427,6 @@ int Creature::determineNonCreatureAnimationPhase(bool animateIdle, ThingType* ty
     return animationPhase;
 }
 
-void Creature::postDraw()
-{
-    // Clear expired afterimages periodically
-    if (m_afterimagesClearTimer.ticksElapsed() >= 33.33f) {
-        m_afterimages.erase(std::remove_if(m_afterimages.begin(), m_afterimages.end(), [](const LocalEffect::Afterimage& ai) {
-            return ai.m_timer.ticksElapsed() >= ai.m_duration;
-        }), m_afterimages.end());
-
-        m_afterimagesClearTimer.restart();
-    }
-}
-
 void Creature::drawOutfit(const Rect& destRect, bool resize)
 {
     // Determine the exact size of the outfit based on its category
@@ -349,6 +441,7 @@ void Creature::drawOutfit(const Rect& destRect, bool resize)
     if (g_graphics.canUseFBO()) {
         auto outfitBuffer = g_framebuffers.getTemporaryFrameBuffer();
         outfitBuffer->resize(Size(frameSize, frameSize));
+        g_painter->flush();
         outfitBuffer->bind();
 
         // Enable alpha writing and clear the buffer
@@ -367,7 +460,7 @@ void Creature::drawOutfit(const Rect& destRect, bool resize)
     }
 }
 
-void Creature::drawAfterimage(Point& dest, float scaleFactor, const LocalEffect::Afterimage& afterimage)
+void Creature::drawAfterimage(Point& dest, float scaleFactor, const Afterimage& afterimage, ticks_t now)
 {
     // Set the color for the outfit
     g_painter->setColor(m_outfitColor);
@@ -383,26 +476,31 @@ void Creature::drawAfterimage(Point& dest, float scaleFactor, const LocalEffect:
             if (yPattern > 0 && !(m_outfit.getAddons() & (1 << (yPattern - 1))))
                 continue;
 
-            // Set opacity based on the afterimage's timer
-            float oldOpacity = g_painter->getOpacity();
-            g_painter->setOpacity(1 - std::max(afterimage.m_timer.ticksElapsed() / afterimage.m_duration, 0.0f));
+            // Set opacity based on the afterimage's age, the saved state brings it back afterwards
+            g_painter->saveState();
+            g_painter->setOpacity(afterimage.getOpacity(now));
             auto* datType = rawGetThingType();
 
+            // Colorize the whole layer in one pass when supported, the opacity then covers the masks as well
+            if (drawColorizedLayer(datType, dest, scaleFactor, afterimage.xPattern, yPattern, afterimage.zPattern, afterimage.animationPhase)) {
+                g_painter->restoreSavedState();
+                continue;
+            }
+
             // Draw the current layer of the outfit
-            datType->draw(dest, scaleFactor, 0, afterimage.m_xPattern, yPattern, afterimage.m_zPattern, afterimage.m_animationPhase, nullptr);
-            g_painter->setOpacity(oldOpacity);
+            if (!g_spriteAtlas.drawThing(datType, dest, scaleFactor, 0, afterimage.xPattern, yPattern, afterimage.zPattern, afterimage.animationPhase))
+                datType->draw(dest, scaleFactor, 0, afterimage.xPattern, yPattern, afterimage.zPattern, afterimage.animationPhase, nullptr);
+            g_painter->restoreSavedState();
 
             // Draw additional layers with color if the outfit has multiple layers
             if (getLayers() > 1) {
-                auto oldColor = g_painter->getColor();
-                auto oldComposition = g_painter->getCompositionMode();
-
+                g_painter->saveState();
                 g_painter->setCompositionMode(Painter::CompositionMode_Multiply);
 
                 // Helper function to draw each layer with its respective color
                 auto drawLayerColor = [&](Color color, SpriteMask mask) {
                     g_painter->setColor(color);
-                    datType->draw(dest, scaleFactor, mask, afterimage.m_xPattern, yPattern, afterimage.m_zPattern, afterimage.m_animationPhase);
+                    datType->draw(dest, scaleFactor, mask, afterimage.xPattern, yPattern, afterimage.zPattern, afterimage.animationPhase);
                 };
 
                 // Draw each layer with its respective color
@@ -412,8 +510,7 @@ void Creature::drawAfterimage(Point& dest, float scaleFactor, const LocalEffect:
                 drawLayerColor(m_outfit.getFeetColor(), SpriteMaskBlue);
 
                 // Restore previous color and composition mode
-                g_painter->setColor(oldColor);
-                g_painter->setCompositionMode(oldComposition);
+                g_painter->restoreSavedState();
             }
         }
     }
@@ -434,7 +531,7 @@ void Creature::drawInformation(const Point& point, bool useGray, const Rect& par
     backgroundRect.bind(parentRect);
 
     // Calculate the text rectangle for the creature's name
-    auto nameSize = m_nameCache.getTextSize();
+    Size nameSize = m_nameRun ? m_nameRun->size : Size();
     Rect textRect(point.x - nameSize.width() / 2.0f, point.y - 12, nameSize);
     textRect.bind(parentRect);
 
@@ -477,11 +574,9 @@ void Creature::drawInformation(const Point& point, bool useGray, const Rect& par
         }
     }
 
-    // Draw the creature's name if the flag is set
-    if (drawFlags & Otc::DrawNames) {
-        g_painter->setColor(fillColor);
-        m_nameCache.draw(textRect);
-    }
+    // Queue the creature's name if the flag is set, MapView flushes all names in one batch
+    if (drawFlags & Otc::DrawNames)
+        g_textBatcher.add(m_nameRun, textRect.topLeft(), fillColor);
 
     // Helper function to draw icons (skull, shield, emblem, etc.)
     auto drawIcon = [&](Otc::IconType type, const TexturePtr& texture, int xOffset, int yOffset) {
@@ -514,6 +609,10 @@ void Creature::walk(const Position& previousPosition, const Position& currentPos
     // Exit if the creature hasn't moved
     if (previousPosition == currentPosition) return;
 
+    // Drop the previous step from the walking index before starting a new one
+    if (m_walking) g_walkingCreatures.removeLeavingCreature(m_lastStepFromPosition, this);
+    g_walkingCreatures.addLeavingCreature(previousPosition, this);
+
     // Determine the direction of the last step
     m_lastStepDirection = previousPosition.getDirectionFromPosition(currentPosition);
     m_lastStepFromPosition = previousPosition;
@@ -521,6 +620,7 @@ void Creature::walk(const Position& previousPosition, const Position& currentPos
     setDirection(m_lastStepDirection);
 
     // Start walking and reset relevant timers and variables
+    invalidateStepDuration();
     m_walking = true;
     m_walkTimer.restart();
     m_walkedPixels = 0;
@@ -546,42 +646,24 @@ void Creature::stopWalk()
 void Creature::jump(int height, int duration)
 {
     // Start a jump if the creature is not already jumping
-    if (!m_jumpOffset.isNull()) return;
+    if (g_timeline.isActive(m_jumpTween)) return;
 
-    m_jumpTimer.restart();
-    m_jumpHeight = height;
-    m_jumpDuration = duration;
-    updateJump();
+    // The arc easing follows the same parabola as a jump of the given height and duration
+    auto self = static_self_cast<Creature>();
+    m_jumpTween = g_timeline.tweenPoint(PointF(0, 0), PointF(height, height), duration, Timeline::Easing_Arc,
+                                        [self](const PointF& offset) { self->m_jumpOffset = offset; },
+                                        [self] { self->m_jumpOffset = PointF(0, 0); self->m_jumpTween = 0; });
 }
 
-void Creature::updateJump()
+void Creature::setOutfitColor(const Color& color, int duration)
 {
-    // Calculate the elapsed time and physics for the jump
-    int elapsedTime = m_jumpTimer.ticksElapsed();
-    double acceleration = -4.0 * m_jumpHeight / (m_jumpDuration * m_jumpDuration);
-    double initialVelocity = 4.0 * m_jumpHeight / m_jumpDuration;
-    
-    double height = acceleration * elapsedTime * elapsedTime + initialVelocity * elapsedTime;
-    int roundedHeight = stdext::round(height);
-    int midJumpDuration = m_jumpDuration / 2;
-
-    // Update the jump offset and schedule the next update if the jump is ongoing
-    if (elapsedTime < m_jumpDuration) {
-        m_jumpOffset = PointF(height, height);
-        int adjustment = elapsedTime < midJumpDuration ? 1 : -1;
+    // Fade from the current outfit color, replacing any fade still running
+    g_timeline.cancel(m_outfitColorTween);
 
-        int nextTime, i = 1;
-        do {
-            nextTime = stdext::round((-initialVelocity + std::sqrt(std::max<double>(initialVelocity * initialVelocity + 4 * acceleration * (roundedHeight + adjustment * i), 0.0)) * adjustment) / (2 * acceleration));
-            ++i;
-        } while (nextTime - elapsedTime == 0 && i < 3);
-
-        auto self = static_self_cast<Creature>();
-        g_dispatcher.scheduleEvent([self] { self->updateJump(); }, nextTime - elapsedTime);
-    } else {
-        // Reset the jump offset when the jump is complete
-        m_jumpOffset = PointF(0, 0);
-    }
+    auto self = static_self_cast<Creature>();
+    m_outfitColorTween = g_timeline.tweenColor(m_outfitColor, color, duration, Timeline::Easing_Linear,
+                                               [self](const Color& value) { self->m_outfitColor = value; },
+                                               [self] { self->m_outfitColorTween = 0; });
 }
 
 void Creature::onPositionChange(const Position& newPosition, const Position& oldPosition)
@@ -706,9 +788,9 @@ void Creature::setDirection(Otc::Direction direction)
 
 void Creature::setName(const std::string& name)
 {
-    // Set the creature's name and update the name cache
+    // Set the creature's name and share the layout of creatures with the same name
     m_name = name;
-    m_nameCache.setText(name);
+    m_nameRun = g_glyphRuns.get(m_nameFont, name);
 }
 
 void Creature::setHealthPercent(uint8 healthPercent)
@@ -749,47 +831,42 @@ void Creature::setOutfit(const Outfit& outfit)
     callLuaField("onOutfitChange", m_outfit, previousOutfit);
 }
 
-void Creature::updateWalkingTile()
+Position Creature::calculateWalkingTilePosition()
 {
-    // Update the tile the creature is walking on based on its position and offset
-    TilePtr newTile = nullptr;
+    // Find the neighbour tile that contains the bottom right corner of the walking creature
     Rect creatureArea(Otc::TILE_PIXELS + (m_walkOffset.x - getDisplacementX()),
                       Otc::TILE_PIXELS + (m_walkOffset.y - getDisplacementY()),
                       Otc::TILE_PIXELS, Otc::TILE_PIXELS);
-    
-    for (int dx = -1; dx <= 1 && !newTile; ++dx) {
-        for (int dy = -1; dy <= 1 && !newTile; ++dy) {
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
             Rect tileArea((dx + 1) * Otc::TILE_PIXELS, (dy + 1) * Otc::TILE_PIXELS, Otc::TILE_PIXELS, Otc::TILE_PIXELS);
-            if (tileArea.contains(creatureArea.bottomRight())) {
-                newTile = g_map.getOrCreateTile(m_position.translated(dx, dy, 0));
-            }
+            if (tileArea.contains(creatureArea.bottomRight()))
+                return m_position.translated(dx, dy, 0);
         }
     }
+    return Position();
+}
 
-    // Update the walking tile and notify the map if necessary
-    if (newTile != m_walkingTile) {
-        if (m_walkingTile) m_walkingTile->removeWalkingCreature(static_self_cast<Creature>());
-        if (newTile) {
-            newTile->addWalkingCreature(static_self_cast<Creature>());
-            if (newTile->isEmpty()) g_map.notificateTileUpdate(newTile->getPosition());
-        }
-        m_walkingTile = newTile;
-    }
+void Creature::updateWalkingTile()
+{
+    // Track the tile the creature is walking over, MapView draws it from there without touching the tile
+    Position walkingTilePosition = calculateWalkingTilePosition();
+    if (walkingTilePosition == m_walkingTilePosition)
+        return;
+
+    g_walkAnimator.moveWalkingTile(static_self_cast<Creature>(), m_walkingTilePosition, walkingTilePosition);
+    m_walkingTilePosition = walkingTilePosition;
 }
 
 void Creature::nextWalkUpdate()
 {
-    // Schedule the next walk update event
-    if (m_walkUpdateEvent) m_walkUpdateEvent->cancel();
+    // Apply the current walk progress right away, the walk animator advances it on every frame
     updateWalk();
-    
-    if (m_walking) {
-        auto self = static_self_cast<Creature>();
-        m_walkUpdateEvent = g_dispatcher.scheduleEvent([self] {
-            self->m_walkUpdateEvent = nullptr;
-            self->nextWalkUpdate();
-        }, getStepDuration(true) / Otc::TILE_PIXELS);
-    }
+    if (!m_walking) return;
+
+    updateWalkingTile();
+    g_walkAnimator.addCreature(static_self_cast<Creature>());
 }
 
 void Creature::updateWalk()
@@ -801,31 +878,28 @@ void Creature::updateWalk()
     
     updateWalkAnimation(traveledPixels, stepTime);
     updateWalkOffset(m_walkedPixels);
-    updateWalkingTile();
-    
+
     // Terminate walking if the step duration is complete
     if (m_walking && m_walkTimer.ticksElapsed() >= getStepDuration()) terminateWalk();
 }
 
 void Creature::terminateWalk()
 {
-    // Cancel any scheduled walk update event
-    if (m_walkUpdateEvent) {
-        m_walkUpdateEvent->cancel();
-        m_walkUpdateEvent = nullptr;
-    }
+    // Stop advancing the walk on every frame
+    g_walkAnimator.removeCreature(static_self_cast<Creature>());
     
+    // Remove the creature from the walking index
+    if (m_walking) g_walkingCreatures.removeLeavingCreature(m_lastStepFromPosition, this);
+
     // If there is a pending direction change, apply it
     if (m_walkTurnDirection != Otc::InvalidDirection) {
         setDirection(m_walkTurnDirection);
         m_walkTurnDirection = Otc::InvalidDirection;
     }
     
-    // Remove the creature from the current walking tile
-    if (m_walkingTile) {
-        m_walkingTile->removeWalkingCreature(static_self_cast<Creature>());
-        m_walkingTile = nullptr;
-    }
+    // Forget the tile the creature was walking over
+    g_walkAnimator.moveWalkingTile(static_self_cast<Creature>(), m_walkingTilePosition, Position());
+    m_walkingTilePosition = Position();
     
     // Reset walking state and related attributes
     m_walking = false;
@@ -839,6 +913,7 @@ void Creature::setSpeed(uint16 speed)
     // Store the previous speed and update to the new speed
     uint16 previousSpeed = m_speed;
     m_speed = speed;
+    invalidateStepDuration();
     
     // If the creature is walking, schedule the next walk update
     if (m_walking) nextWalkUpdate();
@@ -855,6 +930,7 @@ void Creature::setBaseSpeed(double baseSpeed)
     // Store the previous base speed and update to the new base speed
     double previousBaseSpeed = m_baseSpeed;
     m_baseSpeed = baseSpeed;
+    invalidateStepDuration();
     
     // Notify Lua scripts about the base speed change
     callLuaField("onBaseSpeedChange", baseSpeed, previousBaseSpeed);
@@ -926,10 +1002,10 @@ void Creature::setShieldTexture(const std::string& filename, bool blink)
         m_showShieldTexture = true;
     }
     
-    // If blinking is enabled and not already blinking, schedule shield update events
-    if (blink && !m_shieldBlink) {
+    // If blinking is enabled and not already blinking, start toggling the shield
+    if (blink && !g_timeline.isActive(m_shieldBlinkTween)) {
         auto self = static_self_cast<Creature>();
-        g_dispatcher.scheduleEvent([self]() { self->updateShield(); }, SHIELD_BLINK_TICKS);
+        m_shieldBlinkTween = g_timeline.toggle(m_showShieldTexture, SHIELD_BLINK_TICKS, 0, [self](bool) { self->updateShield(); });
     }
     
     // Set the shield blink state
@@ -966,6 +1042,7 @@ void Creature::setSpeedFormula(double speedA, double speedB, double speedC)
     m_speedFormula[Otc::SpeedFormulaA] = speedA;
     m_speedFormula[Otc::SpeedFormulaB] = speedB;
     m_speedFormula[Otc::SpeedFormulaC] = speedC;
+    invalidateStepDuration();
 }
 
 bool Creature::hasSpeedFormula()
@@ -980,9 +1057,12 @@ void Creature::addTimedSquare(uint8 color)
     m_showTimedSquare = true;
     m_timedSquareColor = Color::from8bit(color);
     
-    // Schedule an event to remove the timed square after a duration
+    // Hide the timed square after a duration, restarting it if it is already shown
+    g_timeline.cancel(m_timedSquareTween);
     auto self = static_self_cast<Creature>();
-    g_dispatcher.scheduleEvent([self]() { self->removeTimedSquare(); }, VOLATILE_SQUARE_DURATION);
+    m_timedSquareTween = g_timeline.toggle(true, VOLATILE_SQUARE_DURATION, VOLATILE_SQUARE_DURATION,
+                                           [self](bool show) { self->m_showTimedSquare = show; },
+                                           [self] { self->m_timedSquareTween = 0; });
 }
 
 void Creature::updateShield()
@@ -990,15 +1070,17 @@ void Creature::updateShield()
     // Toggle the visibility of the shield texture if blinking
     if (m_shieldBlink) {
         m_showShieldTexture = !m_showShieldTexture;
-        
-        // If the shield is not none, schedule the next shield update
-        if (m_shield != Otc::ShieldNone) {
-            auto self = static_self_cast<Creature>();
-            g_dispatcher.scheduleEvent([self]() { self->updateShield(); }, SHIELD_BLINK_TICKS);
+
+        // Stop blinking once the shield is gone
+        if (m_shield == Otc::ShieldNone) {
+            g_timeline.cancel(m_shieldBlinkTween);
+            m_shieldBlinkTween = 0;
         }
     } else {
         // Ensure the shield texture is shown if not blinking
         m_showShieldTexture = true;
+        g_timeline.cancel(m_shieldBlinkTween);
+        m_shieldBlinkTween = 0;
     }
 }
 
@@ -1007,8 +1089,8 @@ Point Creature::getDrawOffset()
     // Calculate the draw offset based on walking state and tile elevation
     Point drawOffset;
     if (m_walking) {
-        if (m_walkingTile) {
-            drawOffset -= Point(1,1) * m_walkingTile->getDrawElevation();
+        if (const TilePtr& tile = g_map.getTile(m_walkingTilePosition); tile) {
+            drawOffset -= Point(1,1) * tile->getDrawElevation();
         }
         drawOffset += m_walkOffset;
     } else if (const TilePtr& tile = getTile(); tile) {
@@ -1021,11 +1103,22 @@ int Creature::getStepDuration(bool ignoreDiagonal, Otc::Direction dir) {
     // Return 0 if speed is less than 1
     if (m_speed < 1) return 0;
 
-    // Adjust speed based on game features
-    int adjustedSpeed = g_game.getFeature(Otc::GameNewSpeedLaw) ? m_speed * 2 : m_speed;
     Position targetPos = (dir == Otc::InvalidDirection) ? m_lastStepToPosition : m_position.translatedToDirection(dir);
     if (!targetPos.isValid()) targetPos = m_position;
 
+    // The duration of the current step is memoized until the speed, the step or a ground changes
+    int *cached = (dir == Otc::InvalidDirection) ? &m_cachedStepDuration[ignoreDiagonal ? 1 : 0] : nullptr;
+    if (cached) {
+        if (*cached >= 0 && m_cachedStepTarget == targetPos && m_cachedStepGroundRevision == Tile::getGroundRevision())
+            return *cached;
+
+        if (m_cachedStepTarget != targetPos || m_cachedStepGroundRevision != Tile::getGroundRevision()) {
+            invalidateStepDuration();
+            m_cachedStepTarget = targetPos;
+            m_cachedStepGroundRevision = Tile::getGroundRevision();
+        }
+    }
+
     // Determine ground speed from the target tile
     int groundSpeed = 150;
     if (const TilePtr& tile = g_map.getTile(targetPos)) {
@@ -1033,30 +1126,14 @@ int Creature::getStepDuration(bool ignoreDiagonal, Otc::Direction dir) {
             groundSpeed = tile->getGroundSpeed();
     }
 
-    // Calculate step interval based on ground speed and adjusted speed
-    int stepInterval = (groundSpeed > 0 && adjustedSpeed > 0) ? (1000 * groundSpeed) : 1000;
-    if (g_game.getFeature(Otc::GameNewSpeedLaw) && hasSpeedFormula()) {
-        int computedSpeed = std::max(1, (int)std::round(m_speedFormula[Otc::SpeedFormulaA] * log((adjustedSpeed / 2) + m_speedFormula[Otc::SpeedFormulaB]) + m_speedFormula[Otc::SpeedFormulaC]));
-        stepInterval /= computedSpeed;
-    } else {
-        stepInterval /= adjustedSpeed;
-    }
-
-    // Adjust step interval for client version and server beat
-    if (g_game.getClientVersion() >= 900)
-        stepInterval = (stepInterval / g_game.getServerBeat()) * g_game.getServerBeat();
-
-    // Apply diagonal factor if necessary
-    float diagonalFactor = (g_game.getClientVersion() <= 810) ? 2.0f : 3.0f;
-    stepInterval = std::max(stepInterval, g_game.getServerBeat());
-
-    // If the movement is diagonal, apply a diagonal factor to the step interval
-    if (!ignoreDiagonal && (m_lastStepDirection == Otc::NorthWest || m_lastStepDirection == Otc::NorthEast ||
-                            m_lastStepDirection == Otc::SouthWest || m_lastStepDirection == Otc::SouthEast)) {
-        stepInterval *= diagonalFactor;
-    }
-
-    return stepInterval;
+    bool diagonal = !ignoreDiagonal && (m_lastStepDirection == Otc::NorthWest || m_lastStepDirection == Otc::NorthEast ||
+                                        m_lastStepDirection == Otc::SouthWest || m_lastStepDirection == Otc::SouthEast);
+    int stepDuration = calculateStepDuration(m_speed, groundSpeed, g_game.getFeature(Otc::GameNewSpeedLaw),
+                                             m_speedFormula[Otc::SpeedFormulaA], m_speedFormula[Otc::SpeedFormulaB], m_speedFormula[Otc::SpeedFormulaC],
+                                             g_game.getClientVersion(), g_game.getServerBeat(), diagonal);
+    if (cached)
+        *cached = stepDuration;
+    return stepDuration;
 }
 
 Point Creature::getDisplacement() {
@@ -5,12 +5,12 @@
 #include "outfit.h"
 #include "tile.h"
 #include "mapview.h"
-#include "localeffect.h"
+#include "afterimagerenderer.h"
+#include "glyphruncache.h"
 #include <framework/core/scheduledevent.h>
 #include <framework/core/declarations.h>
 #include <framework/core/timer.h>
 #include <framework/graphics/fontmanager.h>
-#include <framework/graphics/cachedtext.h>
 
 
 class Creature : public Thing
@@ -22,14 +22,14 @@ public:
     };
 
     Creature();
+    virtual ~Creature();
 
     virtual void preDraw(const Point& dest, float scaleFactor, bool animate, LightView *lightView);
     virtual void draw(const Point& dest, float scaleFactor, bool animate, LightView *lightView = nullptr);
-    virtual void postDraw();
 
     void internalDrawOutfit(Point dest, float scaleFactor, bool animateWalk, bool animateIdle, Otc::Direction direction, LightView *lightView = nullptr);
     void drawOutfit(const Rect& destRect, bool resize);
-    void drawAfterimage(Point& dest, float scaleFactor, LocalEffect::Afterimage afterimage);
+    void drawAfterimage(Point& dest, float scaleFactor, const Afterimage& afterimage, ticks_t now);
     void drawInformation(const Point& point, bool useGray, const Rect& parentRect, int drawFlags);
 
     void setId(uint32 id) { m_id = id; }
@@ -79,6 +79,7 @@ public:
     Point getWalkOffset() { return m_walkOffset; }
     Position getLastStepFromPosition() { return m_lastStepFromPosition; }
     Position getLastStepToPosition() { return m_lastStepToPosition; }
+    const Position& getWalkingTilePosition() { return m_walkingTilePosition; }
     float getStepProgress() { return m_walkTimer.ticksElapsed() / getStepDuration(); }
     float getStepTicksLeft() { return getStepDuration() - m_walkTimer.ticksElapsed(); }
     ticks_t getWalkTicksElapsed() { return m_walkTimer.ticksElapsed(); }
@@ -106,11 +107,10 @@ public:
     bool isDead() { return m_healthPercent <= 0; }
     bool canBeSeen() { return !isInvisible() || isPlayer(); }
 
-    void startDash() { m_isDashing = true; }
-    void endDash() { m_isDashing = false; }
+    void startDash();
+    void endDash();
     bool isDashing() { return m_isDashing; }
-    bool hasAfterimages() { return m_afterimages.size() > 0; }
-    std::vector<LocalEffect::Afterimage> getAfterimages() { return m_afterimages; };
+    const AfterimageRing& getAfterimages() { return m_afterimages; }
 
     bool isCreature() { return true; }
 
@@ -123,15 +123,22 @@ public:
     virtual void onDeath();
 
 protected:
+    friend class WalkAnimator;
+
     virtual void updateWalkAnimation(int totalPixelsWalked, int stepDuration);
     virtual void updateWalkOffset(int totalPixelsWalked);
+    Position calculateWalkingTilePosition();
     void updateWalkingTile();
     virtual void nextWalkUpdate();
     virtual void updateWalk();
     virtual void terminateWalk();
 
-    void updateOutfitColor(Color color, Color finalColor, Color delta, int duration);
-    void updateJump();
+    void invalidateStepDuration() { m_cachedStepDuration.fill(-1); }
+
+    bool canUseOutfitCache();
+    void drawOutfitComposite(Point dest, float scaleFactor, int xPattern, int animationPhase, LightView *lightView);
+    bool drawColorizedLayer(ThingType *datType, const Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase);
+
 
     uint32 m_id;
     std::string m_name;
@@ -159,13 +166,18 @@ protected:
     stdext::boolean<false> m_showTimedSquare;
     stdext::boolean<false> m_showStaticSquare;
     stdext::boolean<true> m_removed;
-    CachedText m_nameCache;
+    BitmapFontPtr m_nameFont;
+    GlyphRunPtr m_nameRun;
     Color m_informationColor;
     Color m_outfitColor;
-    ScheduledEventPtr m_outfitColorUpdateEvent;
-    Timer m_outfitColorTimer;
+    uint32 m_outfitColorTween;
+    uint32 m_shieldBlinkTween;
+    uint32 m_timedSquareTween;
 
     std::array<double, Otc::LastSpeedFormula> m_speedFormula;
+    std::array<int, 2> m_cachedStepDuration;
+    Position m_cachedStepTarget;
+    uint32 m_cachedStepGroundRevision;
 
     
     int m_walkAnimationPhase;
@@ -173,11 +185,10 @@ protected:
     uint m_footStep;
     Timer m_walkTimer;
     Timer m_footTimer;
-    TilePtr m_walkingTile;
+    Position m_walkingTilePosition;
     stdext::boolean<false> m_walking;
     stdext::boolean<false> m_allowAppearWalk;
     stdext::boolean<false> m_footStepDrawn;
-    ScheduledEventPtr m_walkUpdateEvent;
     ScheduledEventPtr m_walkFinishAnimEvent;
     EventPtr m_disappearEvent;
     Point m_walkOffset;
@@ -190,16 +201,13 @@ protected:
     Position m_lastPosition;
 
     
-    float m_jumpHeight;
-    float m_jumpDuration;
     PointF m_jumpOffset;
-    Timer m_jumpTimer;
+    uint32 m_jumpTween;
 
     
     
     bool m_isDashing;
-    std::vector<LocalEffect::Afterimage> m_afterimages;
-    Timer m_afterimagesClearTimer;
+    AfterimageRing m_afterimages;
 };
 
 
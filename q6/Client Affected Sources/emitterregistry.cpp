@@ -0,0 +1,24 @@
+#include "emitterregistry.h"
+#include "creature.h"
+
+// Global instance of the emitter registry
+EmitterRegistry g_emitters;
+
+void EmitterRegistry::addEmitter(Creature *creature)
+{
+    if (std::find(m_emitters.begin(), m_emitters.end(), creature) == m_emitters.end())
+        m_emitters.push_back(creature);
+}
+
+void EmitterRegistry::removeEmitter(Creature *creature)
+{
+    m_emitters.erase(std::remove(m_emitters.begin(), m_emitters.end(), creature), m_emitters.end());
+}
+
+// Drops creatures that left the map or stopped emitting without calling endDash
+void EmitterRegistry::prune()
+{
+    m_emitters.erase(std::remove_if(m_emitters.begin(), m_emitters.end(), [](Creature *creature) {
+        return creature->isRemoved() || !creature->isDashing();
+    }), m_emitters.end());
+}
@@ -0,0 +1,29 @@
+#ifndef EMITTERREGISTRY_H
+#define EMITTERREGISTRY_H
+
+#include "declarations.h"
+
+/**
+ * Creatures with an active emitter, currently the afterimage trail of a
+ * dash. MapView runs the draw pre-pass over this list only, so the pre-pass
+ * costs nothing while nobody is dashing. The registry does not own the
+ * creatures, a creature drops its entry when it is destroyed.
+ */
+class EmitterRegistry
+{
+public:
+    void addEmitter(Creature *creature);
+    void removeEmitter(Creature *creature);
+    void prune();
+
+    const std::vector<Creature*>& getEmitters() { return m_emitters; }
+    bool isEmpty() { return m_emitters.empty(); }
+    void clear() { m_emitters.clear(); }
+
+private:
+    std::vector<Creature*> m_emitters;
+};
+
+extern EmitterRegistry g_emitters;
+
+#endif
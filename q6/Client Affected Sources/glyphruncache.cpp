@@ -0,0 +1,57 @@
+#include "glyphruncache.h"
+
+#include <framework/graphics/bitmapfont.h>
+
+// Global instance of the glyph run cache
+GlyphRunCache g_glyphRuns;
+
+// Gets the interned run of a string, laying it out on first use
+GlyphRunPtr GlyphRunCache::get(const BitmapFontPtr& font, const std::string& text)
+{
+    if (!font)
+        return nullptr;
+
+    Key key{font.get(), text};
+    auto it = m_runs.find(key);
+    if (it != m_runs.end())
+        return it->second;
+
+    if (m_runs.size() >= PRUNE_THRESHOLD)
+        prune();
+
+    GlyphRunPtr run = layout(font, text);
+    m_runs.emplace(std::move(key), run);
+    return run;
+}
+
+// Drops the runs that are only referenced by the cache
+void GlyphRunCache::prune()
+{
+    for (auto it = m_runs.begin(); it != m_runs.end();) {
+        if (it->second.use_count() == 1)
+            it = m_runs.erase(it);
+        else
+            ++it;
+    }
+}
+
+// Computes the glyph quads of a string the same way the font draws it, without clipping
+GlyphRunPtr GlyphRunCache::layout(const BitmapFontPtr& font, const std::string& text)
+{
+    auto run = std::make_shared<GlyphRun>();
+    run->font = font;
+
+    const std::vector<Point>& positions = font->calculateGlyphsPositions(text, Fw::AlignTopLeft, &run->size);
+    const Rect *textureCoords = font->getGlyphsTextureCoords();
+    const Size *glyphsSize = font->getGlyphsSize();
+
+    run->glyphs.reserve(text.length());
+    for (size_t i = 0; i < text.length(); ++i) {
+        uchar glyph = (uchar)text[i];
+        if (glyph < 32 || positions[i].x < 0)
+            continue;
+
+        run->glyphs.emplace_back(Rect(positions[i], glyphsSize[glyph]), textureCoords[glyph]);
+    }
+    return run;
+}
@@ -0,0 +1,54 @@
+#ifndef GLYPHRUNCACHE_H
+#define GLYPHRUNCACHE_H
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+
+/**
+ * Laid out text: the glyph quads of a string in a font, relative to the
+ * top left corner of its text box.
+ */
+struct GlyphRun
+{
+    BitmapFontPtr font;
+    Size size;
+    std::vector<std::pair<Rect, Rect>> glyphs; // screen rect relative to the text box, font atlas rect
+};
+typedef std::shared_ptr<const GlyphRun> GlyphRunPtr;
+
+/**
+ * Process wide interned glyph runs keyed by font and string, so fifty
+ * creatures sharing a name also share one layout. Runs nobody holds any
+ * more are dropped once the cache grows past PRUNE_THRESHOLD entries.
+ */
+class GlyphRunCache
+{
+public:
+    enum {
+        PRUNE_THRESHOLD = 1024
+    };
+
+    GlyphRunPtr get(const BitmapFontPtr& font, const std::string& text);
+    void prune();
+    void clear() { m_runs.clear(); }
+
+    int getRunCount() { return m_runs.size(); }
+
+private:
+    struct Key {
+        BitmapFont *font;
+        std::string text;
+        bool operator==(const Key& other) const { return font == other.font && text == other.text; }
+    };
+    struct KeyHasher {
+        size_t operator()(const Key& key) const { return std::hash<std::string>()(key.text) ^ (std::hash<BitmapFont*>()(key.font) << 1); }
+    };
+
+    GlyphRunPtr layout(const BitmapFontPtr& font, const std::string& text);
+
+    std::unordered_map<Key, GlyphRunPtr, KeyHasher> m_runs;
+};
+
+extern GlyphRunCache g_glyphRuns;
+
+#endif
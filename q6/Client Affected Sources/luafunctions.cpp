@@ -27,7 +27,14 @@
 #include "uiprogressrect.h"
 #include "uisprite.h"
 #include "outfit.h"
-
+#include "tilepool.h"
+#include "outfitcache.h"
+#include "outfitcolorizer.h"
+#include "outlinecache.h"
+#include "timeline.h"
+#include "spriteatlas.h"
+
+#include <framework/graphics/painter.h>
 #include <framework/luaengine/luainterface.h>
 
 void Client::registerLuaFunctions()
@@ -139,6 +146,61 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_minimap", "loadOtmm", &Minimap::loadOtmm, &g_minimap);
     g_lua.bindSingletonFunction("g_minimap", "saveOtmm", &Minimap::saveOtmm, &g_minimap);
 
+    g_lua.registerSingletonClass("g_tilePool");
+    g_lua.bindSingletonFunction("g_tilePool", "sweep", &TilePool::sweep, &g_tilePool);
+    g_lua.bindSingletonFunction("g_tilePool", "getChunkCount", &TilePool::getChunkCount, &g_tilePool);
+    g_lua.bindSingletonFunction("g_tilePool", "getLiveTileCount", &TilePool::getLiveTileCount, &g_tilePool);
+    g_lua.bindSingletonFunction("g_tilePool", "getSweptTileCount", &TilePool::getSweptTileCount, &g_tilePool);
+    g_lua.bindSingletonFunction("g_tilePool", "getReservedBytes", &TilePool::getReservedBytes, &g_tilePool);
+    g_lua.bindSingletonFunction("g_tilePool", "getUsedBytes", &TilePool::getUsedBytes, &g_tilePool);
+
+    g_lua.registerSingletonClass("g_timeline");
+    g_lua.bindSingletonFunction("g_timeline", "tweenFloat", &Timeline::tweenFloat, &g_timeline);
+    g_lua.bindSingletonFunction("g_timeline", "tweenColor", &Timeline::tweenColor, &g_timeline);
+    g_lua.bindSingletonFunction("g_timeline", "toggle", &Timeline::toggle, &g_timeline);
+    g_lua.bindSingletonFunction("g_timeline", "cancel", &Timeline::cancel, &g_timeline);
+    g_lua.bindSingletonFunction("g_timeline", "isActive", &Timeline::isActive, &g_timeline);
+    g_lua.bindSingletonFunction("g_timeline", "getTweenCount", &Timeline::getTweenCount, &g_timeline);
+
+    g_lua.registerSingletonClass("g_outfitCache");
+    g_lua.bindSingletonFunction("g_outfitCache", "clear", &OutfitCache::clear, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "setMemoryBudget", &OutfitCache::setMemoryBudget, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getMemoryBudget", &OutfitCache::getMemoryBudget, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getMemoryUsage", &OutfitCache::getMemoryUsage, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getEntryCount", &OutfitCache::getEntryCount, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getHits", &OutfitCache::getHits, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getMisses", &OutfitCache::getMisses, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getEvictions", &OutfitCache::getEvictions, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "getHitRate", &OutfitCache::getHitRate, &g_outfitCache);
+    g_lua.bindSingletonFunction("g_outfitCache", "resetStats", &OutfitCache::resetStats, &g_outfitCache);
+
+    g_lua.registerSingletonClass("g_outfitColorizer");
+    g_lua.bindSingletonFunction("g_outfitColorizer", "clear", &OutfitColorizer::clear, &g_outfitColorizer);
+    g_lua.bindSingletonFunction("g_outfitColorizer", "setMemoryBudget", &OutfitColorizer::setMemoryBudget, &g_outfitColorizer);
+    g_lua.bindSingletonFunction("g_outfitColorizer", "getMemoryBudget", &OutfitColorizer::getMemoryBudget, &g_outfitColorizer);
+    g_lua.bindSingletonFunction("g_outfitColorizer", "getMemoryUsage", &OutfitColorizer::getMemoryUsage, &g_outfitColorizer);
+    g_lua.bindSingletonFunction("g_outfitColorizer", "getFrameCount", &OutfitColorizer::getFrameCount, &g_outfitColorizer);
+
+    g_lua.registerSingletonClass("g_outlines");
+    g_lua.bindSingletonFunction("g_outlines", "clear", &OutlineCache::clear, &g_outlines);
+    g_lua.bindSingletonFunction("g_outlines", "setMaxPages", &OutlineCache::setMaxPages, &g_outlines);
+    g_lua.bindSingletonFunction("g_outlines", "getMaxPages", &OutlineCache::getMaxPages, &g_outlines);
+    g_lua.bindSingletonFunction("g_outlines", "getPageCount", &OutlineCache::getPageCount, &g_outlines);
+    g_lua.bindSingletonFunction("g_outlines", "getOutlineCount", &OutlineCache::getOutlineCount, &g_outlines);
+    g_lua.bindSingletonFunction("g_outlines", "getRecycledPages", &OutlineCache::getRecycledPages, &g_outlines);
+
+    g_lua.registerSingletonClass("g_spriteAtlas");
+    g_lua.bindSingletonFunction("g_spriteAtlas", "clear", &SpriteAtlas::clear, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "defragment", &SpriteAtlas::defragment, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "setMaxPages", &SpriteAtlas::setMaxPages, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "getMaxPages", &SpriteAtlas::getMaxPages, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "getPageCount", &SpriteAtlas::getPageCount, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "getSpriteCount", &SpriteAtlas::getSpriteCount, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "getHits", &SpriteAtlas::getHits, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "getMisses", &SpriteAtlas::getMisses, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "getEvictions", &SpriteAtlas::getEvictions, &g_spriteAtlas);
+    g_lua.bindSingletonFunction("g_spriteAtlas", "resetStats", &SpriteAtlas::resetStats, &g_spriteAtlas);
+
     g_lua.registerSingletonClass("g_creatures");
     g_lua.bindSingletonFunction("g_creatures", "getCreatures", &CreatureManager::getCreatures, &g_creatures);
     g_lua.bindSingletonFunction("g_creatures", "getCreatureByName", &CreatureManager::getCreatureByName, &g_creatures);
@@ -299,6 +361,17 @@ void Client::registerLuaFunctions()
     g_lua.bindGlobalFunction("getOutfitColor", Outfit::getColor);
     g_lua.bindGlobalFunction("getAngleFromPos", Position::getAngleFromPositions);
     g_lua.bindGlobalFunction("getDirectionFromPos", Position::getDirectionFromPositions);
+    g_lua.bindGlobalFunction("getRenderStats", [] {
+        const Painter::RenderStats& stats = g_painter->getRenderStats();
+        std::map<std::string, int> fields;
+        fields["drawCalls"] = stats.drawCalls;
+        fields["programBinds"] = stats.programBinds;
+        fields["redundantProgramBinds"] = stats.redundantProgramBinds;
+        fields["uniformUploads"] = stats.uniformUploads;
+        fields["redundantUniformUploads"] = stats.redundantUniformUploads;
+        fields["restoredStateFields"] = stats.restoredStateFields;
+        return fields;
+    });
 
     g_lua.registerClass<ProtocolGame, Protocol>();
     g_lua.bindClassStaticFunction<ProtocolGame>("create", []{ return ProtocolGamePtr(new ProtocolGame); });
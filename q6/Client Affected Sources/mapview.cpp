@@ -7,8 +7,18 @@
 #include "missile.h"
 #include "shadermanager.h"
 #include "lightview.h"
+#include "item.h"
+#include "spritemanager.h"
+#include "thingtypemanager.h"
+#include "translucentlightlayer.h"
+#include "afterimagerenderer.h"
+#include "walkanimator.h"
+#include "emitterregistry.h"
+#include "timeline.h"
+#include "textbatcher.h"
 
 #include <framework/graphics/graphics.h>
+#include <framework/graphics/texture.h>
 #include <framework/graphics/image.h>
 #include <framework/graphics/framebuffermanager.h>
 #include <framework/core/eventdispatcher.h>
@@ -19,7 +29,8 @@ enum {
     NEAR_VIEW_AREA = 1024,
     MID_VIEW_AREA = 4096, 
     FAR_VIEW_AREA = 16384,
-    MAX_TILE_DRAWS = NEAR_VIEW_AREA * 7
+    MAX_TILE_DRAWS = NEAR_VIEW_AREA * 7,
+    MIN_GROUND_RUN_LENGTH = 2
 };
 
 // The MapView class is responsible for rendering a portion of the game map.
@@ -32,7 +43,11 @@ MapView::MapView()
       m_updateTilesPos(0), // Position for updating visible tiles.
       m_fadeOutTime(0), // Shader transition fade out time.
       m_fadeInTime(0), // Shader transition fade in time.
-      m_minimumAmbientLight(0) // Minimum ambient light level.
+      m_minimumAmbientLight(0), // Minimum ambient light level.
+      m_zoneOverlayFlagsRevision(0), // Tile flags revision the zone overlay was built from.
+      m_zoneOverlaySignature(0), // Zone settings the zone overlay was built with.
+      m_groundRunDatSignature(0), // Content the ground run textures were built from.
+      m_groundRunSprSignature(0)
 {
     // Calculate the optimized size for rendering based on the map's aware range.
     m_optimizedSize = Size(g_map.getAwareRange().horizontal(), g_map.getAwareRange().vertical()) * Otc::TILE_PIXELS;
@@ -57,6 +72,15 @@ MapView::~MapView()
 
 void MapView::draw(const Rect& rect)
 {
+    // The map is drawn once per frame, so the previous frame ends here: its streamed vertex data is fenced
+    // and the painter counters are closed.
+    g_painter->endFrame();
+    g_painter->resetRenderStats();
+
+    // Advance walking creatures and cosmetic tweens once per frame before anything is positioned.
+    g_walkAnimator.update();
+    g_timeline.update();
+
     // Update the cache of visible tiles if necessary.
     if (m_mustUpdateVisibleTilesCache || m_updateTilesPos > 0) {
         updateVisibleTilesCache(m_mustUpdateVisibleTilesCache ? 0 : m_updateTilesPos);
@@ -91,10 +115,10 @@ void MapView::draw(const Rect& rect)
 }
 
 void MapView::drawVisibleTilesToFramebuffer(const Position& cameraPosition, float scaleFactor, int drawFlags) {
+    g_painter->flush(); // Queued draws belong to the previous target.
     m_framebuffer->bind();
     cleanFramebufferIfNeeded();
     drawVisibleTiles(cameraPosition, scaleFactor, drawFlags);
-    m_localEffects.clear();
     m_framebuffer->release();
     m_mustDrawVisibleTilesCache = false;
 }
@@ -159,39 +183,290 @@ void MapView::resetLighting()
 
 void MapView::drawVisibleTiles(Position& cameraPosition, float scaleFactor, int drawFlags)
 {
+    // Drop creatures whose afterimages all faded out, then let dashing creatures record this frame's afterimages.
+    g_afterimages.update();
+    preDrawEmitters(cameraPosition, scaleFactor, drawFlags);
+
     // Iterate over cached visible tiles and draw them.
     auto it = m_cachedVisibleTiles.begin();
     auto end = m_cachedVisibleTiles.end();
     
     // Loop through each visible floor from top to bottom.
     for (int z = m_cachedLastVisibleFloor; z >= m_cachedFirstVisibleFloor; --z) {
-        while (it != end) {
-            const TilePtr& tile = *it;
-            Position tilePos = tile->getPosition();
-            if (tilePos.z != z) break; // Stop if the tile is not on the current floor.
-
+        // Find the range of cached tiles that belong to the current floor.
+        auto floorBegin = it;
+        while (it != end && (*it)->getPosition().z == z)
             ++it;
-            drawTileCreatures(tilePos, scaleFactor, drawFlags); // Draw creatures on the tile.
+
+        // Draw runs of identical grounds in one go, then the remaining contents of each tile.
+        if (drawFlags & Otc::DrawGround)
+            drawGroundRuns(floorBegin, it, cameraPosition, scaleFactor);
+
+        // Zones tint the grounds of their floor only, so the remaining grounds go first and the overlay right over them.
+        if (g_map.showZones() && (drawFlags & Otc::DrawGround)) {
+            drawZoneGrounds(floorBegin, it, cameraPosition, scaleFactor, drawFlags);
+            drawZoneOverlay(z, cameraPosition);
+        }
+
+        // Walking creatures come from an overlay, interleaved with the tiles in diagonal draw order.
+        updateWalkingOverlay(z, cameraPosition, drawFlags);
+        size_t overlayIndex = 0;
+        for (auto tileIt = floorBegin; tileIt != it; ++tileIt) {
+            const TilePtr& tile = *tileIt;
+            Point dest = transformPositionTo2D(tile->getPosition(), cameraPosition);
+            if (m_walkingOverlay.empty()) {
+                tile->draw(dest, scaleFactor, drawFlags, m_lightView.get());
+                continue;
+            }
+
+            int order = getDrawOrder(tile->getPosition(), cameraPosition);
+            drawWalkingCreatures(overlayIndex, order, 0, cameraPosition, scaleFactor, drawFlags); // Over tiles that are not drawn.
+            tile->drawBottom(dest, scaleFactor, drawFlags, m_lightView.get());
+            drawWalkingCreatures(overlayIndex, order + 1, tile->getDrawElevation(), cameraPosition, scaleFactor, drawFlags);
+            tile->drawTop(dest, scaleFactor, drawFlags, m_lightView.get());
+        }
+        drawWalkingCreatures(overlayIndex, std::numeric_limits<int>::max(), 0, cameraPosition, scaleFactor, drawFlags);
+
+        if (drawFlags & Otc::DrawCreatures)
+            drawAfterimages(z, cameraPosition, scaleFactor); // Fading afterimages of dashing creatures.
+        drawTranslucentLights(z, cameraPosition, scaleFactor); // Light positions that have no drawable tile.
+        drawMissiles(z, scaleFactor, drawFlags); // Draw missiles on the current floor.
+    }
+}
+
+void MapView::drawZoneGrounds(TileIterator begin, TileIterator end, const Position& cameraPosition, float scaleFactor, int drawFlags)
+{
+    // Draw the grounds not drawn by a run yet, the tiles skip them later. Selected and elevated grounds keep the regular path.
+    for (auto it = begin; it != end; ++it) {
+        const TilePtr& tile = *it;
+        if (tile->isGroundMerged() || tile->isSelected()) continue;
+
+        const ItemPtr& ground = tile->getGround();
+        if (!ground || ground->getElevation() > 0) continue;
+
+        ground->draw(transformPositionTo2D(tile->getPosition(), cameraPosition), scaleFactor, drawFlags & Otc::DrawAnimations, m_lightView.get());
+        tile->setGroundMerged(true);
+    }
+}
+
+void MapView::drawZoneOverlay(int z, const Position& cameraPosition)
+{
+    // Rebuild the overlays only when the visible tiles, tile flags or zone settings changed.
+    uint32 zoneSignature = Tile::getZoneSettingsSignature();
+    if (m_mustUpdateZoneOverlay || m_zoneOverlayFlagsRevision != Tile::getFlagsRevision() || m_zoneOverlaySignature != zoneSignature) {
+        updateZoneOverlay(cameraPosition);
+        m_zoneOverlayFlagsRevision = Tile::getFlagsRevision();
+        m_zoneOverlaySignature = zoneSignature;
+        m_mustUpdateZoneOverlay = false;
+    }
+
+    // Composite the zones of the floor in a single draw, one texel per tile, upper floors then cover it like the grounds below.
+    const TexturePtr& texture = m_zoneOverlayTextures[z];
+    if (!texture) return;
+
+    g_painter->setOpacity(g_map.getZoneOpacity());
+    g_painter->drawTexturedRect(Rect(0, 0, m_drawDimension * m_tileSize), texture, Rect(0, 0, m_drawDimension));
+    g_painter->resetOpacity();
+}
+
+void MapView::updateZoneOverlay(const Position& cameraPosition)
+{
+    // Paint the zone color of each visible ground into the overlay of its floor.
+    std::array<ImagePtr, Otc::MAX_Z + 1> images;
+    for (const TilePtr& tile : m_cachedVisibleTiles) {
+        if (!tile->getGround()) continue;
+
+        uint32 flag = tile->getShownZoneFlag();
+        if (flag == TILESTATE_NONE) continue;
+
+        Point texel = transformPositionTo2D(tile->getPosition(), cameraPosition) / m_tileSize;
+        if (texel.x < 0 || texel.y < 0 || texel.x >= m_drawDimension.width() || texel.y >= m_drawDimension.height()) continue;
+
+        ImagePtr& image = images[tile->getPosition().z];
+        if (!image)
+            image = ImagePtr(new Image(m_drawDimension));
+        image->setPixel(texel.x, texel.y, g_map.getZoneColor(flag));
+    }
+
+    // Floors without zones have no overlay, the others reuse their texture while the view dimension stays the same.
+    for (int z = 0; z <= Otc::MAX_Z; ++z) {
+        TexturePtr& texture = m_zoneOverlayTextures[z];
+        if (!images[z]) {
+            texture = nullptr;
+            continue;
+        }
+
+        if (texture && texture->getSize() == m_drawDimension) {
+            texture->uploadPixels(images[z]);
+        } else {
+            texture = TexturePtr(new Texture(images[z]));
+        }
+        texture->setSmooth(false);
+    }
+}
+
+void MapView::drawTranslucentLights(int z, const Position& cameraPosition, float scaleFactor)
+{
+    if (!m_lightView) return;
+
+    // Only the part of the floor inside the view is queried, floors below the camera are shifted diagonally.
+    int floorOffset = cameraPosition.z - z;
+    Rect area(cameraPosition.x - m_virtualCenterOffset.x + floorOffset, cameraPosition.y - m_virtualCenterOffset.y + floorOffset, m_drawDimension);
+    m_translucentLights.clear();
+    g_translucentLight.getLightsInArea(area, z, m_translucentLights);
+
+    // Drawable tiles add their own translucent light, the rest is read straight from the light layer.
+    for (const Position& pos : m_translucentLights) {
+        if (const TilePtr& tile = g_map.getTile(pos); tile && tile->isDrawable()) continue;
+        m_lightView->addLightSource(transformPositionTo2D(pos, cameraPosition) + Point(16, 16) * scaleFactor, scaleFactor, {1});
+    }
+}
+
+void MapView::updateWalkingOverlay(int z, const Position& cameraPosition, int drawFlags)
+{
+    m_walkingOverlay.clear();
+
+    // Without animation walking creatures stay on their tile and are drawn by it.
+    if (!(drawFlags & Otc::DrawCreatures) || !(drawFlags & Otc::DrawAnimations)) return;
+
+    for (const WalkAnimator::WalkState& state : g_walkAnimator.getWalkStates()) {
+        const Position& tilePos = state.creature->getWalkingTilePosition();
+        if (!tilePos.isValid() || tilePos.z != z) continue;
+
+        Point cell = transformPositionTo2D(tilePos, cameraPosition) / m_tileSize;
+        if (cell.x < 0 || cell.y < 0 || cell.x >= m_drawDimension.width() || cell.y >= m_drawDimension.height()) continue;
+        if (g_map.isCompletelyCovered(tilePos, m_cachedFirstVisibleFloor)) continue;
+
+        m_walkingOverlay.push_back(WalkingOverlayEntry{getDrawOrder(tilePos, cameraPosition), state.creature});
+    }
+
+    std::stable_sort(m_walkingOverlay.begin(), m_walkingOverlay.end(), [](const WalkingOverlayEntry& a, const WalkingOverlayEntry& b) {
+        return a.order < b.order;
+    });
+}
+
+void MapView::drawWalkingCreatures(size_t& index, int beforeOrder, int elevation, const Position& cameraPosition, float scaleFactor, int drawFlags)
+{
+    // Draw the overlay entries that come before the given draw order, at the elevation of the tile they walk over.
+    for (; index < m_walkingOverlay.size() && m_walkingOverlay[index].order < beforeOrder; ++index) {
+        const CreaturePtr& creature = m_walkingOverlay[index].creature;
+        Point dest = transformPositionTo2D(creature->getPosition(), cameraPosition) - elevation * scaleFactor;
+        creature->draw(dest, scaleFactor, drawFlags & Otc::DrawAnimations, m_lightView.get());
+    }
+}
+
+void MapView::drawAfterimages(int z, const Position& cameraPosition, float scaleFactor)
+{
+    if (g_afterimages.isEmpty()) return;
+
+    // All afterimages of the floor are drawn in one pass, relative to the screen position of the floor origin.
+    Point floorOrigin = transformPositionTo2D(Position(0, 0, z), cameraPosition);
+    g_afterimages.draw(z, floorOrigin, m_tileSize, scaleFactor);
+}
+
+void MapView::drawGroundRuns(TileIterator begin, TileIterator end, const Position& cameraPosition, float scaleFactor)
+{
+    // Gather the tiles whose ground may take part in a run, reusing the storage of the previous floor.
+    std::vector<TilePtr>& candidates = m_groundRunCandidates;
+    candidates.clear();
+    for (auto it = begin; it != end; ++it) {
+        if (canMergeGround(*it))
+            candidates.push_back(*it);
+    }
+    if (candidates.size() < MIN_GROUND_RUN_LENGTH) {
+        candidates.clear();
+        return;
+    }
+
+    // Order the candidates row by row so horizontal neighbours become adjacent.
+    std::sort(candidates.begin(), candidates.end(), [](const TilePtr& a, const TilePtr& b) {
+        const Position& posA = a->getPosition();
+        const Position& posB = b->getPosition();
+        return posA.y != posB.y ? posA.y < posB.y : posA.x < posB.x;
+    });
+
+    size_t runStart = 0;
+    for (size_t i = 1; i <= candidates.size(); ++i) {
+        // Extend the run while the next tile is the right neighbour with the same ground.
+        if (i < candidates.size()) {
+            const Position& prev = candidates[i - 1]->getPosition();
+            const Position& cur = candidates[i]->getPosition();
+            if (cur.y == prev.y && cur.x == prev.x + 1 &&
+                candidates[i]->getGround()->getId() == candidates[runStart]->getGround()->getId())
+                continue;
         }
+
+        // Draw the finished run as a single repeated quad; short runs keep the regular path.
+        size_t runLength = i - runStart;
+        const TilePtr& first = candidates[runStart];
+        if (runLength >= MIN_GROUND_RUN_LENGTH) {
+            if (const TexturePtr& texture = getGroundRunTexture(first->getGround())) {
+                Point dest = transformPositionTo2D(first->getPosition(), cameraPosition);
+                g_painter->pushTransformMatrix();
+                g_painter->translate(dest);
+                g_painter->scale(scaleFactor);
+                g_painter->drawRepeatedTexturedRect(Rect(0, 0, runLength * Otc::TILE_PIXELS, Otc::TILE_PIXELS), texture,
+                                                    Rect(0, 0, Otc::TILE_PIXELS, Otc::TILE_PIXELS));
+                g_painter->popTransformMatrix();
+
+                for (size_t j = runStart; j < i; ++j)
+                    candidates[j]->setGroundMerged(true);
+            }
+        }
+        runStart = i;
     }
 
-    drawMissiles(z, scaleFactor, drawFlags); // Draw missiles on the current floor.
+    // Do not keep the tiles alive until the next floor.
+    candidates.clear();
 }
 
-void MapView::drawTileCreatures(Position& tilePos, float scaleFactor, int drawFlags)
+bool MapView::canMergeGround(const TilePtr& tile)
 {
-    // Get creatures on the specified tile position.
-    auto creatures = g_map.getTile(tilePos)->getCreatures();
-    for (const CreaturePtr creature : creatures) {
-        // Prepare the creature for drawing.
-        creature->preDraw(transformPositionTo2D(tilePos, getCameraPosition()), scaleFactor, drawFlags, m_lightView.get());
-
-        // Handle afterimages for the creature.
-        for (const auto& afterimage : creature->getAfterimages()) {
-            TilePtr afterimageTile = g_map.getTile(afterimage.m_position);
-            m_localEffects[(uintptr_t)afterimageTile.get()].push_back(LocalEffect(LocalEffect::LocalEffectType_Afterimage, creature->static_self_cast<Thing>(), afterimage));
+    // Selected tiles are tinted individually.
+    if (tile->isSelected()) return false;
+
+    // Only plain full grounds qualify: one static 32x32 sprite that looks the same on every tile.
+    ItemPtr ground = tile->getGround();
+    if (!ground || !ground->isFullGround()) return false;
+
+    ThingType* type = ground->rawGetThingType();
+    return type->getSize() == Size(1, 1) && type->getLayers() == 1 && type->getAnimationPhases() == 1 &&
+           type->getNumPatternX() == 1 && type->getNumPatternY() == 1 && type->getNumPatternZ() == 1 &&
+           !type->hasDisplacement() && !type->hasElevation() && !type->hasLight();
+}
+
+const TexturePtr& MapView::getGroundRunTexture(const ItemPtr& ground)
+{
+    // Textures built before the sprites or the .dat were reloaded hold the old artwork.
+    uint32 datSignature = g_things.getDatSignature();
+    uint32 sprSignature = g_sprites.getSignature();
+    if (datSignature != m_groundRunDatSignature || sprSignature != m_groundRunSprSignature) {
+        m_groundRunTextures.clear();
+        m_groundRunDatSignature = datSignature;
+        m_groundRunSprSignature = sprSignature;
+    }
+
+    // Build a standalone texture of the ground sprite once so it can be repeated.
+    TexturePtr& texture = m_groundRunTextures[ground->getId()];
+    if (!texture) {
+        std::vector<int> sprites = ground->rawGetThingType()->getSprites();
+        if (!sprites.empty()) {
+            if (ImagePtr image = g_sprites.getSpriteImage(sprites[0]))
+                texture = TexturePtr(new Texture(image));
         }
     }
+    return texture;
+}
+
+void MapView::preDrawEmitters(const Position& cameraPosition, float scaleFactor, int drawFlags)
+{
+    // Only creatures with an active emitter need the pre-pass, so it is free while nobody is dashing.
+    if (g_emitters.isEmpty()) return;
+
+    g_emitters.prune();
+    for (Creature *creature : g_emitters.getEmitters()) {
+        creature->preDraw(transformPositionTo2D(creature->getPosition(), cameraPosition), scaleFactor, drawFlags, m_lightView.get());
+    }
 }
 
 void MapView::drawMissiles(int z, float scaleFactor, int drawFlags)
@@ -245,6 +520,7 @@ void MapView::applyShader(const Rect& srcRect, const Position& cameraPosition)
 
 void MapView::renderFinalFramebuffer(const Rect& rect, const Rect& srcRect, const Point& drawOffset)
 {
+    g_painter->flush(); // Queued draws must not see the raw blend change.
     glDisable(GL_BLEND); // Disable blending for drawing.
     m_framebuffer->draw(rect, srcRect); // Draw the framebuffer content to the screen.
     g_painter->resetShaderProgram(); // Reset the shader program after drawing.
@@ -263,6 +539,13 @@ void MapView::renderCreaturesInformation(const Rect& rect, const Position& camer
 {
     // Render creature information if in NEAR_VIEW mode.
     if (m_viewMode == NEAR_VIEW) {
+        // Bars and icons are recorded and batched by state; a draw only moves past draws it does not overlap,
+        // so stacked creatures and icons sharing a rect keep the order they were drawn in.
+        Painter *painter = g_painter;
+        m_informationPainter.begin(painter);
+        m_informationPainter.setLayer(0, CommandBufferPainter::LayerOrder_ByState);
+        g_painter = &m_informationPainter;
+
         for (const CreaturePtr& creature : m_cachedFloorVisibleCreatures) {
             if (!creature->canBeSeen()) continue; // Skip creatures that cannot be seen.
 
@@ -282,6 +565,10 @@ void MapView::renderCreaturesInformation(const Rect& rect, const Position& camer
             if (m_drawManaBar) { flags |= Otc::DrawManaBar; } // Set flag to draw mana bars if enabled.
             creature->drawInformation(p, g_map.isCovered(pos, m_cachedFirstVisibleFloor), rect, flags); // Draw the creature's information.
         }
+
+        m_informationPainter.flush();
+        g_painter = painter;
+        g_textBatcher.flush(); // Draw every queued name at once.
     }
 }
 
@@ -342,6 +629,7 @@ void MapView::updateVisibleTilesCache(int start)
     bool stop = false;
     m_cachedVisibleTiles.clear(); // Clear the cache of visible tiles.
     m_mustDrawVisibleTilesCache = true; // Indicate that the visible tiles cache must be drawn.
+    m_mustUpdateZoneOverlay = true; // Visible tiles changed, so the zone overlay must be rebuilt.
     m_updateTilesPos = 0; // Reset the update position.
 
     // Process tiles in a spiral pattern from the last visible floor to the first.
@@ -7,7 +7,7 @@
 #include <framework/luaengine/luaobject.h>
 #include <framework/core/declarations.h>
 #include "lightview.h"
-#include "localeffect.h"
+#include <framework/graphics/commandbufferpainter.h>
 
 
 class MapView : public LuaObject
@@ -105,6 +105,20 @@ public:
     MapViewPtr asMapView() { return static_self_cast<MapView>(); }
 
 private:
+    typedef std::vector<TilePtr>::const_iterator TileIterator;
+
+    void drawGroundRuns(TileIterator begin, TileIterator end, const Position& cameraPosition, float scaleFactor);
+    bool canMergeGround(const TilePtr& tile);
+    const TexturePtr& getGroundRunTexture(const ItemPtr& ground);
+    void drawTranslucentLights(int z, const Position& cameraPosition, float scaleFactor);
+    void drawAfterimages(int z, const Position& cameraPosition, float scaleFactor);
+    void preDrawEmitters(const Position& cameraPosition, float scaleFactor, int drawFlags);
+    void updateWalkingOverlay(int z, const Position& cameraPosition, int drawFlags);
+    void drawWalkingCreatures(size_t& index, int beforeOrder, int elevation, const Position& cameraPosition, float scaleFactor, int drawFlags);
+    void drawZoneGrounds(TileIterator begin, TileIterator end, const Position& cameraPosition, float scaleFactor, int drawFlags);
+    void drawZoneOverlay(int z, const Position& cameraPosition);
+    void updateZoneOverlay(const Position& cameraPosition);
+
     Rect calcFramebufferSource(const Size& destSize);
     int calcFirstVisibleFloor();
     int calcLastVisibleFloor();
@@ -112,6 +126,11 @@ private:
         return Point((m_virtualCenterOffset.x + (position.x - relativePosition.x) - (relativePosition.z - position.z)) * m_tileSize,
                      (m_virtualCenterOffset.y + (position.y - relativePosition.y) - (relativePosition.z - position.z)) * m_tileSize);
     }
+    // Rank of a position in the diagonal order visible tiles are cached and drawn in
+    int getDrawOrder(const Position& position, const Position& relativePosition) {
+        Point cell = transformPositionTo2D(position, relativePosition) / m_tileSize;
+        return (cell.x + cell.y) * m_drawDimension.width() + cell.x;
+    }
 
     int m_lockedFirstVisibleFloor;
     int m_cachedFirstVisibleFloor;
@@ -155,7 +174,24 @@ private:
     float m_fadeOutTime;
     stdext::boolean<true> m_shaderSwitchDone;
 
-    std::map<uintptr_t, std::vector<LocalEffect>> m_localEffects;
+    std::unordered_map<uint16, TexturePtr> m_groundRunTextures;
+    uint32 m_groundRunDatSignature;
+    uint32 m_groundRunSprSignature;
+    std::vector<TilePtr> m_groundRunCandidates;
+
+    struct WalkingOverlayEntry {
+        int order;
+        CreaturePtr creature;
+    };
+    std::vector<WalkingOverlayEntry> m_walkingOverlay;
+    std::vector<Position> m_translucentLights;
+
+    std::array<TexturePtr, Otc::MAX_Z + 1> m_zoneOverlayTextures;
+    uint32 m_zoneOverlayFlagsRevision;
+    uint32 m_zoneOverlaySignature;
+    stdext::boolean<true> m_mustUpdateZoneOverlay;
+
+    CommandBufferPainter m_informationPainter;
 };
 
 #endif
@@ -0,0 +1,140 @@
+#include "outfitcache.h"
+#include "thingtype.h"
+#include "thingtypemanager.h"
+#include "spritemanager.h"
+
+#include <framework/graphics/graphics.h>
+#include <framework/graphics/painter.h>
+#include <framework/graphics/framebuffer.h>
+#include <framework/graphics/framebuffermanager.h>
+
+// Global instance of the outfit frame cache
+OutfitCache g_outfitCache;
+
+// Constructor for the OutfitCache class
+OutfitCache::OutfitCache()
+    : m_memoryBudget(DEFAULT_MEMORY_BUDGET), m_hits(0), m_misses(0), m_evictions(0), m_datSignature(0), m_sprSignature(0) {}
+
+// Checks if the whole composite of an outfit and its optional mount fits into a cell when anchored at its tile
+bool OutfitCache::canCache(ThingType *outfitType, ThingType *mountType)
+{
+    if (!outfitType || !g_graphics.canUseFBO())
+        return false;
+
+    // The mount is drawn at the tile shifted by its displacement, the outfit is then drawn where the mount left it
+    Point shift = mountType ? mountType->getDisplacement() : Point(0, 0);
+    if (mountType && !fitsCell(mountType, shift))
+        return false;
+    return fitsCell(outfitType, shift);
+}
+
+// Checks if a type drawn at the tile moved up-left by shift stays inside the cell, the tile sits at its bottom right
+bool OutfitCache::fitsCell(ThingType *type, const Point& shift)
+{
+    // ThingType::draw moves the sprites up-left by the displacement once more and grows them up-left with the size
+    Point bottomRight = Point(0, 0) - shift - type->getDisplacement();
+    Point topLeft = bottomRight - (type->getSize().toPoint() - Point(1, 1)) * Otc::TILE_PIXELS;
+    return topLeft.x >= -CELL_ANCHOR && topLeft.y >= -CELL_ANCHOR && bottomRight.x <= 0 && bottomRight.y <= 0;
+}
+
+// Drops every frame once the sprites or the .dat were reloaded, the cells still hold the old artwork
+void OutfitCache::checkContentSignatures()
+{
+    uint32 datSignature = g_things.getDatSignature();
+    uint32 sprSignature = g_sprites.getSignature();
+    if (datSignature == m_datSignature && sprSignature == m_sprSignature)
+        return;
+
+    clear();
+    m_datSignature = datSignature;
+    m_sprSignature = sprSignature;
+}
+
+// Draws a composited outfit frame, rendering it into a cell first on a miss
+bool OutfitCache::draw(const OutfitFrameKey& key, const Point& dest, float scaleFactor, const std::function<void(const Point&)>& composite)
+{
+    checkContentSignatures();
+
+    Cell cell;
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        // Move the entry to the front of the LRU list
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+        cell = it->second.cell;
+        m_hits++;
+    } else {
+        if (!allocateCell(cell))
+            return false;
+
+        renderCell(cell, composite);
+        m_lru.push_front(key);
+        m_entries[key] = Entry{cell, m_lru.begin()};
+        m_misses++;
+    }
+
+    // The frame is anchored so the creature tile sits at the bottom right of the cell
+    Rect screenRect(dest - Point(CELL_ANCHOR, CELL_ANCHOR) * scaleFactor, Size(CELL_SIZE, CELL_SIZE) * scaleFactor);
+    g_painter->drawTexturedRect(screenRect, m_pages[cell.page]->getTexture(), cell.rect);
+    return true;
+}
+
+// Drops every cached frame and releases the atlas pages
+void OutfitCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_freeCells.clear();
+    m_pages.clear();
+}
+
+// Finds a cell for a new frame, growing the atlas or evicting the least recently used frame
+bool OutfitCache::allocateCell(Cell& cell)
+{
+    if (m_freeCells.empty()) {
+        if (getMemoryUsage() + PAGE_SIZE * PAGE_SIZE * 4 <= m_memoryBudget) {
+            FrameBufferPtr page = g_framebuffers.createFrameBuffer();
+            page->setSmooth(false);
+            page->resize(Size(PAGE_SIZE, PAGE_SIZE));
+
+            int pageIndex = m_pages.size();
+            m_pages.push_back(page);
+            for (int i = CELLS_PER_PAGE - 1; i >= 0; --i) {
+                Rect rect((i % CELLS_PER_ROW) * CELL_SIZE, (i / CELLS_PER_ROW) * CELL_SIZE, CELL_SIZE, CELL_SIZE);
+                m_freeCells.push_back(Cell{pageIndex, rect});
+            }
+        } else if (!m_lru.empty()) {
+            auto entryIt = m_entries.find(m_lru.back());
+            m_freeCells.push_back(entryIt->second.cell);
+            m_entries.erase(entryIt);
+            m_lru.pop_back();
+            m_evictions++;
+        } else {
+            return false;
+        }
+    }
+
+    cell = m_freeCells.back();
+    m_freeCells.pop_back();
+    return true;
+}
+
+// Composites a frame into its cell
+void OutfitCache::renderCell(const Cell& cell, const std::function<void(const Point&)>& composite)
+{
+    const FrameBufferPtr& page = m_pages[cell.page];
+
+    // Draws the painter still holds belong to the current target
+    g_painter->flush();
+    page->bind();
+
+    // Clear whatever the previous owner of the cell left behind
+    g_painter->setAlphaWriting(true);
+    g_painter->setCompositionMode(Painter::CompositionMode_Replace);
+    g_painter->setColor(Color::alpha);
+    g_painter->drawFilledRect(cell.rect);
+    g_painter->resetCompositionMode();
+    g_painter->resetColor();
+
+    composite(cell.rect.topLeft() + Point(CELL_ANCHOR, CELL_ANCHOR));
+    page->release();
+}
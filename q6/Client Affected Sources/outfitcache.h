@@ -0,0 +1,99 @@
+#ifndef OUTFITCACHE_H
+#define OUTFITCACHE_H
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+
+struct OutfitFrameKey
+{
+    uint16 lookType;
+    uint16 mount;
+    uint8 head, body, legs, feet;
+    uint8 addons;
+    uint8 xPattern;
+    uint8 animationPhase;
+
+    bool operator==(const OutfitFrameKey& other) const {
+        return lookType == other.lookType && mount == other.mount &&
+               head == other.head && body == other.body && legs == other.legs && feet == other.feet &&
+               addons == other.addons && xPattern == other.xPattern && animationPhase == other.animationPhase;
+    }
+};
+
+struct OutfitFrameKeyHasher
+{
+    size_t operator()(const OutfitFrameKey& key) const {
+        uint64 packed = (uint64)key.lookType | ((uint64)key.mount << 16) | ((uint64)key.head << 32) |
+                        ((uint64)key.body << 40) | ((uint64)key.legs << 48) | ((uint64)key.feet << 56);
+        uint32 extra = key.addons | (key.xPattern << 8) | (key.animationPhase << 16);
+        return std::hash<uint64>()(packed) ^ (std::hash<uint32>()(extra) * 31);
+    }
+};
+
+/**
+ * Cache of fully composited outfit frames (base sprite, colored masks,
+ * addons and mount). Frames are rendered once into cells of framebuffer
+ * atlas pages, so drawing a cached creature is a single textured quad.
+ * Cells are recycled in least recently used order once the memory budget
+ * is reached, and every frame is dropped when the sprites or the .dat are
+ * reloaded.
+ */
+class OutfitCache
+{
+public:
+    enum {
+        CELL_SIZE = 96,
+        CELL_ANCHOR = CELL_SIZE - 32,
+        PAGE_SIZE = 960,
+        CELLS_PER_ROW = PAGE_SIZE / CELL_SIZE,
+        CELLS_PER_PAGE = CELLS_PER_ROW * CELLS_PER_ROW,
+        DEFAULT_MEMORY_BUDGET = 32 * 1024 * 1024
+    };
+
+    OutfitCache();
+
+    bool canCache(ThingType *outfitType, ThingType *mountType);
+    bool draw(const OutfitFrameKey& key, const Point& dest, float scaleFactor, const std::function<void(const Point&)>& composite);
+    void clear();
+
+    void setMemoryBudget(int bytes) { m_memoryBudget = bytes; clear(); }
+    int getMemoryBudget() { return m_memoryBudget; }
+    int getMemoryUsage() { return m_pages.size() * PAGE_SIZE * PAGE_SIZE * 4; }
+    int getEntryCount() { return m_entries.size(); }
+
+    int getHits() { return m_hits; }
+    int getMisses() { return m_misses; }
+    int getEvictions() { return m_evictions; }
+    float getHitRate() { return (m_hits + m_misses) > 0 ? m_hits / (float)(m_hits + m_misses) : 0.0f; }
+    void resetStats() { m_hits = m_misses = m_evictions = 0; }
+
+private:
+    struct Cell {
+        int page;
+        Rect rect;
+    };
+    struct Entry {
+        Cell cell;
+        std::list<OutfitFrameKey>::iterator lruIt;
+    };
+
+    bool fitsCell(ThingType *type, const Point& shift);
+    void checkContentSignatures();
+    bool allocateCell(Cell& cell);
+    void renderCell(const Cell& cell, const std::function<void(const Point&)>& composite);
+
+    std::vector<FrameBufferPtr> m_pages;
+    std::vector<Cell> m_freeCells;
+    std::unordered_map<OutfitFrameKey, Entry, OutfitFrameKeyHasher> m_entries;
+    std::list<OutfitFrameKey> m_lru;
+    int m_memoryBudget;
+    int m_hits;
+    int m_misses;
+    int m_evictions;
+    uint32 m_datSignature;
+    uint32 m_sprSignature;
+};
+
+extern OutfitCache g_outfitCache;
+
+#endif
@@ -0,0 +1,92 @@
+#include "outfitcolorizer.h"
+#include "thingtype.h"
+#include "spritemanager.h"
+
+#include <framework/graphics/painter.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/texture.h>
+
+// Global instance of the outfit colorizer
+OutfitColorizer g_outfitColorizer;
+
+// Constructor for the OutfitColorizer class
+OutfitColorizer::OutfitColorizer()
+    : m_memoryBudget(DEFAULT_MEMORY_BUDGET), m_memoryUsage(0) {}
+
+// Checks if the painter can colorize the type in a single pass
+bool OutfitColorizer::canColorize(ThingType *type)
+{
+    return type && type->getLayers() > 1 && g_painter->canColorizeOutfits();
+}
+
+// Retrieves the base and mask textures of a creature frame, building them on first use
+const OutfitColorizer::Frame& OutfitColorizer::getFrame(ThingType *type, int xPattern, int yPattern, int zPattern, int animationPhase)
+{
+    uint64 key = ((uint64)type->getId() << 32) | (xPattern << 24) | (yPattern << 16) | (zPattern << 8) | animationPhase;
+    auto it = m_frames.find(key);
+    if (it != m_frames.end()) {
+        // Move the entry to the front of the LRU list
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+        return it->second.frame;
+    }
+
+    // Base and mask are both RGBA images of the whole frame
+    Size frameSize = type->getSize() * Otc::TILE_PIXELS;
+    int bytes = frameSize.area() * 4 * 2;
+
+    // Make room for the new frame, the least recently used ones go first
+    while (!m_lru.empty() && m_memoryUsage + bytes > m_memoryBudget) {
+        auto evictIt = m_frames.find(m_lru.back());
+        m_memoryUsage -= evictIt->second.bytes;
+        m_frames.erase(evictIt);
+        m_lru.pop_back();
+    }
+
+    Frame frame;
+    frame.base = TexturePtr(new Texture(buildFrameImage(type, 0, xPattern, yPattern, zPattern, animationPhase)));
+    frame.mask = TexturePtr(new Texture(buildFrameImage(type, 1, xPattern, yPattern, zPattern, animationPhase)));
+    frame.base->setSmooth(false);
+    frame.mask->setSmooth(false);
+
+    m_lru.push_front(key);
+    m_memoryUsage += bytes;
+    Entry& entry = m_frames[key];
+    entry = Entry{frame, bytes, m_lru.begin()};
+    return entry.frame;
+}
+
+// Drops every cached frame
+void OutfitColorizer::clear()
+{
+    m_frames.clear();
+    m_lru.clear();
+    m_memoryUsage = 0;
+}
+
+// Assembles the untrimmed image of one layer of a frame from its sprites, the mask layer keeps its raw colors
+ImagePtr OutfitColorizer::buildFrameImage(ThingType *type, int layer, int xPattern, int yPattern, int zPattern, int animationPhase)
+{
+    Size size = type->getSize();
+    ImagePtr image(new Image(size * Otc::TILE_PIXELS));
+    std::vector<int> sprites = type->getSprites();
+
+    for (int h = 0; h < size.height(); ++h) {
+        for (int w = 0; w < size.width(); ++w) {
+            uint index = ((((((animationPhase % type->getAnimationPhases())
+                            * type->getNumPatternZ() + zPattern)
+                            * type->getNumPatternY() + yPattern)
+                            * type->getNumPatternX() + xPattern)
+                            * type->getLayers() + layer)
+                            * size.height() + h)
+                            * size.width() + w;
+            if (index >= sprites.size())
+                continue;
+
+            if (ImagePtr spriteImage = g_sprites.getSpriteImage(sprites[index])) {
+                Point spritePos = Point(size.width() - w - 1, size.height() - h - 1) * Otc::TILE_PIXELS;
+                image->blit(spritePos, spriteImage);
+            }
+        }
+    }
+    return image;
+}
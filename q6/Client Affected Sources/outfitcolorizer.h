@@ -0,0 +1,55 @@
+#ifndef OUTFITCOLORIZER_H
+#define OUTFITCOLORIZER_H
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+
+/**
+ * Builds matching base and color mask textures for creature frames, so the
+ * painter can colorize head, body, legs and feet in a single fragment pass
+ * instead of drawing four multiplied mask layers on top of the base sprite.
+ * Frames are dropped in least recently used order once the memory budget
+ * is reached.
+ */
+class OutfitColorizer
+{
+public:
+    enum {
+        DEFAULT_MEMORY_BUDGET = 16 * 1024 * 1024
+    };
+
+    struct Frame {
+        TexturePtr base;
+        TexturePtr mask;
+    };
+
+    OutfitColorizer();
+
+    const Frame& getFrame(ThingType *type, int xPattern, int yPattern, int zPattern, int animationPhase);
+    bool canColorize(ThingType *type);
+
+    void clear();
+
+    void setMemoryBudget(int bytes) { m_memoryBudget = bytes; clear(); }
+    int getMemoryBudget() { return m_memoryBudget; }
+    int getMemoryUsage() { return m_memoryUsage; }
+    int getFrameCount() { return m_frames.size(); }
+
+    static ImagePtr buildFrameImage(ThingType *type, int layer, int xPattern, int yPattern, int zPattern, int animationPhase);
+
+private:
+    struct Entry {
+        Frame frame;
+        int bytes;
+        std::list<uint64>::iterator lruIt;
+    };
+
+    std::unordered_map<uint64, Entry> m_frames;
+    std::list<uint64> m_lru;
+    int m_memoryBudget;
+    int m_memoryUsage;
+};
+
+extern OutfitColorizer g_outfitColorizer;
+
+#endif
@@ -0,0 +1,188 @@
+#include "outlinecache.h"
+#include "outfitcolorizer.h"
+#include "thingtype.h"
+
+#include <framework/core/clock.h>
+#include <framework/graphics/glutil.h>
+#include <framework/graphics/painter.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/texture.h>
+
+// Global instance of the outline cache
+OutlineCache g_outlines;
+
+// Constructor for the OutlineCache class
+OutlineCache::OutlineCache()
+    : m_currentPage(-1), m_shelfHeight(0), m_maxPages(DEFAULT_MAX_PAGES), m_recycledPages(0) {}
+
+// Draws the outline of a thing frame at the place the frame itself would be drawn
+void OutlineCache::draw(ThingType *type, const Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase, const Color& color)
+{
+    const Outline *outline = getOutline(type, xPattern, yPattern, zPattern, animationPhase);
+    if (!outline)
+        return;
+
+    // Upload the outlines packed into the page since the last draw, or the whole page when it is new or was wiped
+    Page& page = m_pages[outline->page];
+    page.lastUse = g_clock.millis();
+    if (!page.texture || page.dirty) {
+        if (page.texture)
+            page.texture->uploadPixels(page.image);
+        else
+            page.texture = TexturePtr(new Texture(page.image));
+        page.texture->setSmooth(false);
+        page.dirty = false;
+        page.dirtyRects.clear();
+    } else if (!page.dirtyRects.empty()) {
+        // Binding the page behind the painter's back, so its queued draws go first and its binding is restored after
+        g_painter->flush();
+        GLint boundTexture = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+        glBindTexture(GL_TEXTURE_2D, page.texture->getId());
+        for (const Rect& rect : page.dirtyRects)
+            uploadRect(page, rect);
+        glBindTexture(GL_TEXTURE_2D, boundTexture);
+        page.dirtyRects.clear();
+    }
+
+    // Same placement as ThingType::draw for an untrimmed frame, grown by the outline width
+    Point offset = -type->getDisplacement() - (type->getSize().toPoint() - Point(1, 1)) * Otc::TILE_PIXELS - Point(OUTLINE_WIDTH, OUTLINE_WIDTH);
+    Rect screenRect(dest + offset * scaleFactor, outline->rect.size() * scaleFactor);
+
+    // The caller may be tinting the thing itself, so its color is put back afterwards
+    Color previousColor = g_painter->getColor();
+    g_painter->setColor(color);
+    g_painter->drawTexturedRect(screenRect, page.texture, outline->rect);
+    g_painter->setColor(previousColor);
+}
+
+// Drops every outline and atlas page
+void OutlineCache::clear()
+{
+    m_pages.clear();
+    m_outlines.clear();
+    m_currentPage = -1;
+    m_shelfCursor = Point();
+    m_shelfHeight = 0;
+}
+
+// Computes a white mask of the pixels next to an opaque pixel, left, right, above or below.
+// Rows are processed as 64 bit words so a whole row of the frame is dilated in a few operations.
+ImagePtr OutlineCache::dilate(const ImagePtr& frame)
+{
+    const Size frameSize = frame->getSize();
+    const int width = frameSize.width() + OUTLINE_WIDTH * 2;
+    const int height = frameSize.height() + OUTLINE_WIDTH * 2;
+    const int words = (width + 63) / 64;
+
+    // Opacity bitmask of the frame, padded so the outline can grow past its edges
+    std::vector<uint64> opaque(words * height, 0);
+    const uint8 *pixels = frame->getPixelData();
+    for (int y = 0; y < frameSize.height(); ++y) {
+        uint64 *row = &opaque[(y + OUTLINE_WIDTH) * words];
+        for (int x = 0; x < frameSize.width(); ++x) {
+            if (pixels[(y * frameSize.width() + x) * 4 + 3] != 0) {
+                int bit = x + OUTLINE_WIDTH;
+                row[bit / 64] |= (uint64)1 << (bit % 64);
+            }
+        }
+    }
+
+    ImagePtr outline(new Image(Size(width, height)));
+    for (int y = 0; y < height; ++y) {
+        const uint64 *row = &opaque[y * words];
+        const uint64 *above = y > 0 ? &opaque[(y - 1) * words] : nullptr;
+        const uint64 *below = y < height - 1 ? &opaque[(y + 1) * words] : nullptr;
+
+        for (int w = 0; w < words; ++w) {
+            // Horizontal neighbours with the carries between words
+            uint64 left = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+            uint64 right = (row[w] >> 1) | (w < words - 1 ? row[w + 1] << 63 : 0);
+            uint64 mask = left | right | (above ? above[w] : 0) | (below ? below[w] : 0);
+
+            for (int x = w * 64; mask && x < width; ++x, mask >>= 1) {
+                if (mask & 1)
+                    outline->setPixel(x, y, Color::white);
+            }
+        }
+    }
+    return outline;
+}
+
+// Gets the atlas location of a frame outline, dilating it on first use
+const OutlineCache::Outline *OutlineCache::getOutline(ThingType *type, int xPattern, int yPattern, int zPattern, int animationPhase)
+{
+    if (!type)
+        return nullptr;
+
+    uint64 key = ((uint64)type->getCategory() << 40) | ((uint64)type->getId() << 32) | (xPattern << 24) | (yPattern << 16) | (zPattern << 8) | animationPhase;
+    auto it = m_outlines.find(key);
+    if (it != m_outlines.end())
+        return &it->second;
+
+    ImagePtr image = dilate(OutfitColorizer::buildFrameImage(type, 0, xPattern, yPattern, zPattern, animationPhase));
+    Outline outline;
+    if (!allocate(image->getSize(), outline))
+        return nullptr;
+
+    Page& page = m_pages[outline.page];
+    page.image->blit(outline.rect.topLeft(), image);
+    page.dirtyRects.push_back(outline.rect);
+    page.keys.push_back(key);
+    return &(m_outlines[key] = outline);
+}
+
+// Reserves room for an outline with shelf packing, moving on to a new or recycled page when the current one is full
+bool OutlineCache::allocate(const Size& size, Outline& outline)
+{
+    if (size.width() > PAGE_SIZE || size.height() > PAGE_SIZE)
+        return false;
+
+    if (m_currentPage >= 0 && m_shelfCursor.x + size.width() > PAGE_SIZE) {
+        m_shelfCursor = Point(0, m_shelfCursor.y + m_shelfHeight);
+        m_shelfHeight = 0;
+    }
+
+    if (m_currentPage < 0 || m_shelfCursor.y + size.height() > PAGE_SIZE) {
+        if ((int)m_pages.size() < m_maxPages) {
+            m_pages.push_back(Page{ImagePtr(new Image(Size(PAGE_SIZE, PAGE_SIZE))), nullptr, true, {}, 0, {}});
+            m_currentPage = m_pages.size() - 1;
+        } else {
+            auto lru = std::min_element(m_pages.begin(), m_pages.end(), [](const Page& a, const Page& b) { return a.lastUse < b.lastUse; });
+            m_currentPage = lru - m_pages.begin();
+            recyclePage(m_currentPage);
+        }
+        m_shelfCursor = Point();
+        m_shelfHeight = 0;
+    }
+
+    outline.page = m_currentPage;
+    outline.rect = Rect(m_shelfCursor, size);
+    m_shelfCursor.x += size.width();
+    m_shelfHeight = std::max<int>(m_shelfHeight, size.height());
+    return true;
+}
+
+// Forgets every outline of a page and wipes it so it can be packed again
+void OutlineCache::recyclePage(int index)
+{
+    Page& page = m_pages[index];
+    for (uint64 key : page.keys)
+        m_outlines.erase(key);
+    page.keys.clear();
+    page.image = ImagePtr(new Image(Size(PAGE_SIZE, PAGE_SIZE)));
+    page.dirty = true;
+    page.dirtyRects.clear();
+    page.lastUse = g_clock.millis();
+    m_recycledPages++;
+}
+
+// Uploads one rect of a page to its bound texture, staged because OpenGL ES 2 has no unpack row length
+void OutlineCache::uploadRect(Page& page, const Rect& rect)
+{
+    const uint8 *pixels = page.image->getPixelData();
+    m_rectPixels.resize(rect.width() * rect.height() * 4);
+    for (int y = 0; y < rect.height(); ++y)
+        memcpy(&m_rectPixels[y * rect.width() * 4], pixels + ((rect.top() + y) * PAGE_SIZE + rect.left()) * 4, rect.width() * 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.left(), rect.top(), rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, m_rectPixels.data());
+}
@@ -0,0 +1,68 @@
+#ifndef OUTLINECACHE_H
+#define OUTLINECACHE_H
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+
+/**
+ * One pixel outline masks of thing frames, dilated once on the CPU and
+ * packed into atlas pages. Drawing an outline (dash highlight, target or
+ * selection) is then a single quad tinted by the painter color, instead of
+ * a shader taking four extra samples per fragment on a second outfit draw.
+ * At most a budget of pages is kept; once it is reached, the least
+ * recently drawn page is wiped and packed again with new outlines.
+ */
+class OutlineCache
+{
+public:
+    enum {
+        PAGE_SIZE = 512,
+        OUTLINE_WIDTH = 1,
+        DEFAULT_MAX_PAGES = 4
+    };
+
+    OutlineCache();
+
+    void draw(ThingType *type, const Point& dest, float scaleFactor, int xPattern, int yPattern, int zPattern, int animationPhase, const Color& color);
+    void clear();
+
+    void setMaxPages(int maxPages) { m_maxPages = std::max<int>(1, maxPages); clear(); }
+    int getMaxPages() { return m_maxPages; }
+    int getPageCount() { return m_pages.size(); }
+    int getOutlineCount() { return m_outlines.size(); }
+    int getRecycledPages() { return m_recycledPages; }
+
+    static ImagePtr dilate(const ImagePtr& frame);
+
+private:
+    struct Page {
+        ImagePtr image;
+        TexturePtr texture;
+        bool dirty;
+        std::vector<Rect> dirtyRects;
+        ticks_t lastUse;
+        std::vector<uint64> keys;
+    };
+    struct Outline {
+        int page;
+        Rect rect;
+    };
+
+    const Outline *getOutline(ThingType *type, int xPattern, int yPattern, int zPattern, int animationPhase);
+    bool allocate(const Size& size, Outline& outline);
+    void recyclePage(int index);
+    void uploadRect(Page& page, const Rect& rect);
+
+    std::vector<Page> m_pages;
+    std::unordered_map<uint64, Outline> m_outlines;
+    int m_currentPage;
+    Point m_shelfCursor;
+    int m_shelfHeight;
+    int m_maxPages;
+    int m_recycledPages;
+    std::vector<uint8> m_rectPixels;
+};
+
+extern OutlineCache g_outlines;
+
+#endif
@@ -1,6 +1,7 @@
 #include "painter.h"
 #include "graphics.h"
 
+#include <framework/core/logger.h>
 #include <framework/platform/platformwindow.h>
 
 Painter *g_painter = nullptr;
@@ -8,4 +9,35 @@ Painter *g_painter = nullptr;
 Painter::Painter()
 {
     // Initialize the painter with default settings.
+    m_paintType = PaintType_Textured;
+}
+
+// Names of the declared custom uniforms, indexed by handle
+static std::vector<std::string>& uniformNames()
+{
+    // Function local so handles can be declared during static initialization
+    static std::vector<std::string> names;
+    return names;
+}
+
+// Declares a custom uniform and returns its handle, declaring the same name twice returns the same handle.
+// Past MAX_UNIFORM_HANDLES the handle is invalid and setting it does nothing.
+Painter::UniformHandle Painter::declareUniform(const std::string& name)
+{
+    std::vector<std::string>& names = uniformNames();
+    auto it = std::find(names.begin(), names.end(), name);
+    if(it != names.end())
+        return it - names.begin();
+
+    if(names.size() >= MAX_UNIFORM_HANDLES) {
+        g_logger.error(stdext::format("unable to declare uniform '%s', only %d custom uniforms are supported", name, (int)MAX_UNIFORM_HANDLES));
+        return INVALID_UNIFORM_HANDLE;
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+const std::vector<std::string>& Painter::getDeclaredUniforms()
+{
+    return uniformNames();
 }
\ No newline at end of file
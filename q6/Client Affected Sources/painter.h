@@ -31,6 +31,30 @@ public:
         PaintType_SolidColor,
         PaintType_Creature,
     };
+    // Toggles compiled into the creature program variants
+    enum ShaderFeature {
+        ShaderFeature_OutfitColorize = 1 << 0,
+        LAST_SHADER_FEATURE = ShaderFeature_OutfitColorize
+    };
+    struct RenderStats {
+        int drawCalls = 0;
+        int programBinds = 0;
+        int redundantProgramBinds = 0;
+        int uniformUploads = 0;
+        int redundantUniformUploads = 0;
+        int restoredStateFields = 0;
+    };
+
+    // Index of a custom shader uniform, declared once and resolved per program at link time
+    typedef int UniformHandle;
+    enum {
+        MAX_UNIFORM_HANDLES = 32,
+        INVALID_UNIFORM_HANDLE = -1
+    };
+
+    static UniformHandle declareUniform(const std::string& name);
+    static bool isValidUniform(UniformHandle handle) { return handle >= 0 && handle < MAX_UNIFORM_HANDLES; }
+    static const std::vector<std::string>& getDeclaredUniforms();
 
     Painter();
     virtual ~Painter() { }
@@ -67,6 +91,15 @@ public:
     virtual void applyPaintType(PaintType paintType) { }
     virtual void setBrushConfiguration(const BrushConfiguration& brushConfiguration) { }
     virtual void flushBrushConfigurations(PaintType paintType) { };
+    virtual void setUniform(UniformHandle handle, int value) { }
+    virtual void setUniform(UniformHandle handle, float value) { }
+    virtual void setUniform(UniformHandle handle, const PointF& value) { }
+    virtual void setUniform(UniformHandle handle, const Color& value) { }
+    virtual void setOutfitMaskTexture(const TexturePtr& maskTexture) { }
+    virtual void setShaderFeatures(int features) { }
+    virtual bool canColorizeOutfits() { return false; }
+    // Whether consecutive textured rects sharing a texture end up in one draw call
+    virtual bool canBatchTexturedRects() { return false; }
 
     virtual void scale(float x, float y) = 0;
     void scale(float factor) { scale(factor, factor); }
@@ -98,6 +131,15 @@ public:
 
     virtual bool hasShaders() = 0;
 
+    // Submits draws a painter may still be holding, needed before touching GL state directly (framebuffers, raw GL calls)
+    virtual void flush() { }
+    // Called by the frame owner once the frame has been submitted
+    virtual void endFrame() { }
+
+    // Counters of GL work, resetRenderStats closes the frame being counted and getRenderStats reports it
+    const RenderStats& getRenderStats() { return m_lastFrameRenderStats; }
+    void resetRenderStats() { m_lastFrameRenderStats = m_renderStats; m_renderStats = RenderStats(); }
+
 protected:
     PainterShaderProgram *m_shaderProgram;
     CompositionMode m_compositionMode;
@@ -108,6 +150,8 @@ protected:
 
     PaintType m_paintType;
     std::vector<BrushConfiguration> m_brushConfigurationVector;
+    RenderStats m_renderStats;
+    RenderStats m_lastFrameRenderStats;
 };
 
 extern Painter *g_painter;
@@ -1,5 +1,6 @@
 #include "painterogl2.h"
 #include "painterogl2_shadersources.h"
+#include <framework/core/logger.h>
 #include <framework/platform/platformwindow.h>
 
 // Global pointer to the PainterOGL2 instance
@@ -8,39 +9,91 @@ PainterOGL2 *g_painterOGL2 = nullptr;
 // Constructor for the PainterOGL2 class
 PainterOGL2::PainterOGL2()
 {
-    // Resets the state of the painter
+    // Resets the state of the painter, nothing is saved yet so no field counts as changed
+    m_dirtyStateFields = 0;
     resetState();
+    m_dirtyStateFields = 0;
     
     // Initialize shader programs to nullptr
     m_drawProgram = nullptr;
+    m_boundProgram = nullptr;
+
+    // Uniform shadows start at version 0, so the first draw with every program uploads everything
+    m_colorVersion = m_opacityVersion = m_resolutionVersion = 1;
     
     // Create shared pointers for different shader programs
     m_drawTexturedProgram = std::make_shared<PainterShaderProgram>();
     m_drawSolidColorProgram = std::make_shared<PainterShaderProgram>();
-    m_drawCreatureProgram = std::make_shared<PainterShaderProgram>();
     
     // Ensure that all shader programs are successfully created
-    assert(m_drawTexturedProgram && m_drawSolidColorProgram && m_drawCreatureProgram);
-    
-    // Add vertex and fragment shaders to the textured program and link them
-    m_drawTexturedProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsVertexShader + glslPositionOnlyVertexShader);
-    m_drawTexturedProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslTextureSrcFragmentShader);
-    m_drawTexturedProgram->link();
-    
-    // Add vertex and fragment shaders to the solid color program and link them
-    m_drawSolidColorProgram->addShaderFromSourceCode(Shader::Vertex, glslMainVertexShader + glslPositionOnlyVertexShader);
-    m_drawSolidColorProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslSolidColorFragmentShader);
-    m_drawSolidColorProgram->link();
+    assert(m_drawTexturedProgram && m_drawSolidColorProgram);
     
-    // Add vertex and fragment shaders to the creature program and link them
-    m_drawCreatureProgram->addShaderFromSourceCode(Shader::Vertex, glslMainWithTexCoordsVertexShader + glslPositionOnlyVertexShader);
-    m_drawCreatureProgram->addShaderFromSourceCode(Shader::Fragment, glslMainFragmentShader + glslCreatureSrcFragmentShader);
-    m_drawCreatureProgram->link();
-    
-    // Bind the creature program and set a outfit value
-    m_drawCreatureProgram->bind();
-    m_drawCreatureProgram->setOutfitValue("u_IsDashing", 0);
-    PainterShaderProgram::release();
+    // Compile and link every program
+    linkProgram(m_drawTexturedProgram.get(), glslMainWithTexCoordsVertexShader + glslPositionOnlyVertexShader, glslMainFragmentShader + glslTextureSrcFragmentShader);
+    linkProgram(m_drawSolidColorProgram.get(), glslMainVertexShader + glslPositionOnlyVertexShader, glslMainFragmentShader + glslSolidColorFragmentShader);
+
+    // Resolve the custom uniforms declared so far, later declarations are resolved on their first flush
+    for(PainterShaderProgram *program : { m_drawTexturedProgram.get(), m_drawSolidColorProgram.get() })
+        resolveUniforms(program);
+
+    // The plain creature variant is the common case, so it is built up front
+    m_shaderFeatures = 0;
+    m_failedShaderFeatures = 0;
+    getCreatureProgram(0);
+}
+
+// Compiles and links a program from its sources
+bool PainterOGL2::linkProgram(PainterShaderProgram *program, const std::string& vertexSource, const std::string& fragmentSource)
+{
+    program->addShaderFromSourceCode(Shader::Vertex, vertexSource);
+    program->addShaderFromSourceCode(Shader::Fragment, fragmentSource);
+    return program->link();
+}
+
+// Gets the creature program variant compiled with the given features, compiling it on first use
+PainterShaderProgram *PainterOGL2::getCreatureProgram(int features)
+{
+    PainterShaderProgramPtr& program = m_creaturePrograms[features];
+    if(program)
+        return program.get();
+
+    static const std::pair<int, const char*> featureDefines[] = {
+        { ShaderFeature_OutfitColorize, "OUTFIT_COLORIZE" }
+    };
+    std::string defines;
+    for(const auto& feature : featureDefines) {
+        if(features & feature.first)
+            defines += stdext::format("#define %s\n", feature.second);
+    }
+
+    program = std::make_shared<PainterShaderProgram>();
+    if(!linkProgram(program.get(), glslMainWithTexCoordsVertexShader + glslPositionOnlyVertexShader, defines + glslMainFragmentShader + glslCreatureSrcFragmentShader) && features != 0) {
+        // The plain variant takes over for good, so a broken variant is neither retried nor reported as usable
+        g_logger.error(stdext::format("unable to link the creature program with features %d, using the plain one", features));
+        m_failedShaderFeatures |= features;
+        PainterShaderProgramPtr fallback = m_creaturePrograms[0];
+        if(!fallback) {
+            getCreatureProgram(0);
+            fallback = m_creaturePrograms[0];
+        }
+        program = fallback;
+        return program.get();
+    }
+    resolveUniforms(program.get());
+    m_creatureProgramFeatures[program.get()] = features;
+    return program.get();
+}
+
+// Selects the optional creature features of the next creature draws, the outfit mask adds its own
+void PainterOGL2::setShaderFeatures(int features)
+{
+    if(features == m_shaderFeatures)
+        return;
+
+    m_shaderFeatures = features;
+    m_dirtyStateFields |= StateField_ShaderFeatures;
+    if(m_paintType == PaintType_Creature)
+        applyPaintType(PaintType_Creature);
 }
 
 // Binds the painter and enables necessary attribute arrays
@@ -49,6 +102,9 @@ void PainterOGL2::bind()
     PainterOGL::bind();
     PainterShaderProgram::enableAttributeArray(PainterShaderProgram::VERTEX_ATTR);
     PainterShaderProgram::enableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+
+    // Whatever ran in between may have switched programs
+    m_boundProgram = nullptr;
 }
 
 // Unbinds the painter and disables attribute arrays
@@ -57,6 +113,226 @@ void PainterOGL2::unbind()
     PainterShaderProgram::disableAttributeArray(PainterShaderProgram::VERTEX_ATTR);
     PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
     PainterShaderProgram::release();
+    m_boundProgram = nullptr;
+}
+
+// Pushes a snapshot of the state, the fields changed from here on are tracked in a fresh dirty mask
+void PainterOGL2::saveState()
+{
+    m_savedStates.push_back(SavedState{m_resolution, m_transformMatrix, m_projectionMatrix, m_textureMatrix,
+                                       m_color, m_opacity, m_compositionMode, m_blendEquation, m_clipRect,
+                                       m_texture, m_shaderProgram, m_alphaWriting, m_shaderFeatures, m_dirtyStateFields});
+    m_dirtyStateFields = 0;
+}
+
+void PainterOGL2::saveAndResetState()
+{
+    saveState();
+    resetState();
+    setShaderFeatures(0);
+}
+
+// Re-applies only the fields changed since the matching save, so restoring an untouched state costs nothing
+void PainterOGL2::restoreSavedState()
+{
+    assert(!m_savedStates.empty());
+    SavedState state = m_savedStates.back();
+    m_savedStates.pop_back();
+
+    uint32 dirty = m_dirtyStateFields;
+    m_renderStats.restoredStateFields += std::bitset<32>(dirty).count();
+
+    // Resolution goes first since it also rebuilds the projection matrix
+    if(dirty & StateField_Resolution)
+        setResolution(state.resolution);
+    if(dirty & StateField_Color)
+        setColor(state.color);
+    if(dirty & StateField_Opacity)
+        setOpacity(state.opacity);
+    if(dirty & StateField_CompositionMode)
+        setCompositionMode(state.compositionMode);
+    if(dirty & StateField_BlendEquation)
+        setBlendEquation(state.blendEquation);
+    if(dirty & StateField_ClipRect)
+        setClipRect(state.clipRect);
+    if(dirty & StateField_ShaderFeatures)
+        setShaderFeatures(state.shaderFeatures);
+    if(dirty & StateField_ShaderProgram)
+        setShaderProgram(state.shaderProgram);
+    if(dirty & StateField_AlphaWriting)
+        setAlphaWriting(state.alphaWriting);
+    if(dirty & StateField_Texture)
+        setTexture(state.texture);
+
+    // Matrices change outside of the setters (transforms, framebuffers), so they are compared by value
+    if(m_transformMatrix != state.transformMatrix || m_projectionMatrix != state.projectionMatrix || m_textureMatrix != state.textureMatrix) {
+        flush();
+        setTransformMatrix(state.transformMatrix);
+        setProjectionMatrix(state.projectionMatrix);
+        setTextureMatrix(state.textureMatrix);
+    }
+
+    // The fields are back to their saved values, so only the changes of the enclosing level remain
+    m_dirtyStateFields = state.dirtyFields;
+}
+
+// State setters only touch, version and mark dirty a value that really changed
+void PainterOGL2::setTexture(Texture *texture)
+{
+    if(texture == m_texture)
+        return;
+    PainterOGL::setTexture(texture);
+    m_dirtyStateFields |= StateField_Texture;
+}
+
+void PainterOGL2::setClipRect(const Rect& clipRect)
+{
+    if(clipRect == m_clipRect)
+        return;
+    PainterOGL::setClipRect(clipRect);
+    m_dirtyStateFields |= StateField_ClipRect;
+}
+
+void PainterOGL2::setColor(const Color& color)
+{
+    if(color == m_color)
+        return;
+    PainterOGL::setColor(color);
+    m_colorVersion++;
+    m_dirtyStateFields |= StateField_Color;
+}
+
+void PainterOGL2::setAlphaWriting(bool enable)
+{
+    if(enable == m_alphaWriting)
+        return;
+    PainterOGL::setAlphaWriting(enable);
+    m_dirtyStateFields |= StateField_AlphaWriting;
+}
+
+void PainterOGL2::setBlendEquation(BlendEquation blendEquation)
+{
+    if(blendEquation == m_blendEquation)
+        return;
+    PainterOGL::setBlendEquation(blendEquation);
+    m_dirtyStateFields |= StateField_BlendEquation;
+}
+
+void PainterOGL2::setShaderProgram(PainterShaderProgram *shaderProgram)
+{
+    if(shaderProgram == m_shaderProgram)
+        return;
+    PainterOGL::setShaderProgram(shaderProgram);
+    m_dirtyStateFields |= StateField_ShaderProgram;
+}
+
+void PainterOGL2::setCompositionMode(CompositionMode compositionMode)
+{
+    if(compositionMode == m_compositionMode)
+        return;
+    PainterOGL::setCompositionMode(compositionMode);
+    m_dirtyStateFields |= StateField_CompositionMode;
+}
+
+void PainterOGL2::setOpacity(float opacity)
+{
+    if(opacity == m_opacity)
+        return;
+    PainterOGL::setOpacity(opacity);
+    m_opacityVersion++;
+    m_dirtyStateFields |= StateField_Opacity;
+}
+
+void PainterOGL2::setResolution(const Size& resolution)
+{
+    PainterOGL::setResolution(resolution);
+    m_resolutionVersion++;
+    m_dirtyStateFields |= StateField_Resolution;
+}
+
+// Binds a program unless it is already the current one
+void PainterOGL2::bindProgram(PainterShaderProgram *program)
+{
+    if(program == m_boundProgram) {
+        m_renderStats.redundantProgramBinds++;
+        return;
+    }
+    program->bind();
+    m_boundProgram = program;
+    m_renderStats.programBinds++;
+}
+
+// Gets the uniform shadow of a program, dropping the shadows of programs that were released
+PainterOGL2::ProgramUniforms& PainterOGL2::getProgramUniforms(PainterShaderProgram *program)
+{
+    // An expired shadow belongs to a released program, never to one that took its address
+    auto it = m_programUniforms.find(program);
+    if(it != m_programUniforms.end() && !it->second.program.expired())
+        return it->second;
+
+    // New programs are rare, so released ones are only collected when one shows up
+    for(it = m_programUniforms.begin(); it != m_programUniforms.end();) {
+        if(!it->second.program.expired()) {
+            ++it;
+            continue;
+        }
+        if(it->first == m_boundProgram)
+            m_boundProgram = nullptr;
+        it = m_programUniforms.erase(it);
+    }
+
+    ProgramUniforms& uniforms = m_programUniforms[program];
+    uniforms.program = program->static_self_cast<PainterShaderProgram>();
+    return uniforms;
+}
+
+// Uploads the painter state the current program has not seen yet
+void PainterOGL2::uploadUniforms(bool textured)
+{
+    ProgramUniforms& uniforms = getProgramUniforms(m_drawProgram);
+    int uploads = 0, skipped = 0;
+
+    // Matrices change outside of this class, so they are compared by value
+    auto uploadMatrix = [&](Matrix3& shadow, const Matrix3& value, bool known, void (PainterShaderProgram::*setter)(const Matrix3&)) {
+        if(known && shadow == value) {
+            skipped++;
+            return;
+        }
+        (m_drawProgram->*setter)(value);
+        shadow = value;
+        uploads++;
+    };
+    uploadMatrix(uniforms.transformMatrix, m_transformMatrix, uniforms.hasMatrices, &PainterShaderProgram::setTransformMatrix);
+    uploadMatrix(uniforms.projectionMatrix, m_projectionMatrix, uniforms.hasMatrices, &PainterShaderProgram::setProjectionMatrix);
+    uniforms.hasMatrices = true;
+    if(textured) {
+        uploadMatrix(uniforms.textureMatrix, m_textureMatrix, uniforms.hasTextureMatrix, &PainterShaderProgram::setTextureMatrix);
+        uniforms.hasTextureMatrix = true;
+    }
+
+    // Scalar state is versioned by its setters
+    if(uniforms.opacityVersion != m_opacityVersion) {
+        m_drawProgram->setOpacity(m_opacity);
+        uniforms.opacityVersion = m_opacityVersion;
+        uploads++;
+    } else
+        skipped++;
+    if(uniforms.colorVersion != m_colorVersion) {
+        m_drawProgram->setColor(m_color);
+        uniforms.colorVersion = m_colorVersion;
+        uploads++;
+    } else
+        skipped++;
+    if(uniforms.resolutionVersion != m_resolutionVersion) {
+        m_drawProgram->setResolution(m_resolution);
+        uniforms.resolutionVersion = m_resolutionVersion;
+        uploads++;
+    } else
+        skipped++;
+    m_drawProgram->updateTime();
+
+    m_renderStats.uniformUploads += uploads;
+    m_renderStats.redundantUniformUploads += skipped;
 }
 
 // Draws coordinates using the specified draw mode
@@ -66,35 +342,60 @@ void PainterOGL2::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     if(coordsBuffer.getVertexCount() == 0 || (coordsBuffer.getTextureCoordCount() > 0 && m_texture && m_texture->isEmpty()))
         return;
     
-    // Bind the current drawing program and set various matrices and properties
-    m_drawProgram->bind();
-    m_drawProgram->setTransformMatrix(m_transformMatrix);
-    m_drawProgram->setProjectionMatrix(m_projectionMatrix);
-    m_drawProgram->setOpacity(m_opacity);
-    m_drawProgram->setColor(m_color);
-    m_drawProgram->setResolution(m_resolution);
-    m_drawProgram->updateTime();
-    
     // Determine if the drawing is textured
     bool textured = coordsBuffer.getTextureCoordCount() > 0 && m_texture;
+
+    // Bind the current drawing program and upload only the uniforms that changed since its last draw
+    bindProgram(m_drawProgram);
+    uploadUniforms(textured);
+    m_renderStats.drawCalls++;
+
     if(textured) {
-        m_drawProgram->setTextureMatrix(m_textureMatrix);
         m_drawProgram->bindMultiTextures();
+        
+        // Bind the outfit mask on the second texture unit for the colorize program
+        auto featuresIt = m_outfitMaskTexture ? m_creatureProgramFeatures.find(m_drawProgram) : m_creatureProgramFeatures.end();
+        if(featuresIt != m_creatureProgramFeatures.end() && (featuresIt->second & ShaderFeature_OutfitColorize)) {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, m_outfitMaskTexture->getId());
+            glActiveTexture(GL_TEXTURE0);
+        }
     }
     
     // Update caches and determine if hardware caching is used
     coordsBuffer.updateCaches();
     bool hardwareCached = coordsBuffer.isHardwareCached();
+
+    // Immediate draws stream their vertices into the ring buffer instead of passing client arrays
+    const float *vertexArray = hardwareCached ? nullptr : coordsBuffer.getVertexArray();
+    const float *textureCoordArray = hardwareCached ? nullptr : coordsBuffer.getTextureCoordArray();
+    bool streamed = false;
+    if(!hardwareCached) {
+        int size = coordsBuffer.getVertexCount() * 2 * sizeof(float);
+        int alignedSize = (size + StreamingVertexBuffer::ALIGNMENT - 1) & ~(StreamingVertexBuffer::ALIGNMENT - 1);
+        if(m_streamBuffer.reserve(textured ? alignedSize * 2 : alignedSize)) {
+            int vertexOffset = m_streamBuffer.write(vertexArray, size);
+            int textureCoordOffset = textured ? m_streamBuffer.write(textureCoordArray, size) : 0;
+            vertexArray = reinterpret_cast<const float*>((intptr_t)vertexOffset);
+            textureCoordArray = reinterpret_cast<const float*>((intptr_t)textureCoordOffset);
+            m_streamBuffer.bind();
+            streamed = true;
+        }
+    }
     
     // Set attribute arrays for texture coordinates if textured
     if(textured) {
-        m_drawProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, hardwareCached ? nullptr : coordsBuffer.getTextureCoordArray(), 2);
+        m_drawProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, textureCoordArray, 2);
     } else {
         PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
     }
     
     // Set attribute arrays for vertex coordinates
-    m_drawProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, hardwareCached ? nullptr : coordsBuffer.getVertexArray(), 2);
+    m_drawProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, vertexArray, 2);
+
+    // The attribute pointers keep the buffer, unbinding leaves client arrays working for everyone else
+    if(streamed)
+        StreamingVertexBuffer::unbind();
     
     // Draw the arrays using the specified draw mode
     glDrawArrays(drawMode == Triangles ? GL_TRIANGLES : GL_TRIANGLE_STRIP, 0, coordsBuffer.getVertexCount());
@@ -107,6 +408,7 @@ void PainterOGL2::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
 // Applies the paint type by setting the appropriate shader program
 void PainterOGL2::applyPaintType(PaintType paintType)
 {
+    m_paintType = paintType;
     switch(paintType) {
         case PaintType_Textured:
             setShaderProgram(m_drawTexturedProgram.get());
@@ -115,11 +417,109 @@ void PainterOGL2::applyPaintType(PaintType paintType)
             setShaderProgram(m_drawSolidColorProgram.get());
             break;
         case PaintType_Creature:
-            setShaderProgram(m_drawCreatureProgram.get());
+            setShaderProgram(getCreatureProgram(getCreatureFeatures()));
             break;
     }
 }
 
+// Sets the color mask used to colorize outfits in one pass, switching the creature program accordingly
+void PainterOGL2::setOutfitMaskTexture(const TexturePtr& maskTexture)
+{
+    m_outfitMaskTexture = maskTexture;
+    if(m_paintType == PaintType_Creature)
+        applyPaintType(PaintType_Creature);
+}
+
+// Queues custom uniform values, they are uploaded to the program picked by the next flush
+void PainterOGL2::setUniform(UniformHandle handle, int value)
+{
+    if(!isValidUniform(handle))
+        return;
+
+    PendingUniform& uniform = m_pendingUniforms[handle];
+    uniform.type = PendingUniform::Int32;
+    uniform.intValue = value;
+    m_dirtyUniforms.set(handle);
+}
+
+void PainterOGL2::setUniform(UniformHandle handle, float value)
+{
+    if(!isValidUniform(handle))
+        return;
+
+    PendingUniform& uniform = m_pendingUniforms[handle];
+    uniform.type = PendingUniform::Float;
+    uniform.floatValues[0] = value;
+    m_dirtyUniforms.set(handle);
+}
+
+void PainterOGL2::setUniform(UniformHandle handle, const PointF& value)
+{
+    if(!isValidUniform(handle))
+        return;
+
+    PendingUniform& uniform = m_pendingUniforms[handle];
+    uniform.type = PendingUniform::Vector2;
+    uniform.floatValues[0] = value.x;
+    uniform.floatValues[1] = value.y;
+    m_dirtyUniforms.set(handle);
+}
+
+void PainterOGL2::setUniform(UniformHandle handle, const Color& value)
+{
+    if(!isValidUniform(handle))
+        return;
+
+    PendingUniform& uniform = m_pendingUniforms[handle];
+    uniform.type = PendingUniform::Color4;
+    uniform.floatValues[0] = value.rF();
+    uniform.floatValues[1] = value.gF();
+    uniform.floatValues[2] = value.bF();
+    uniform.floatValues[3] = value.aF();
+    m_dirtyUniforms.set(handle);
+}
+
+// Gets the locations of the declared custom uniforms in a program, -1 for the ones it does not use
+const std::vector<int>& PainterOGL2::resolveUniforms(PainterShaderProgram *program)
+{
+    std::vector<int>& locations = getProgramUniforms(program).customLocations;
+    const std::vector<std::string>& names = getDeclaredUniforms();
+    while(locations.size() < names.size())
+        locations.push_back(glGetUniformLocation(program->getProgramId(), names[locations.size()].c_str()));
+    return locations;
+}
+
+// Uploads the queued custom uniforms to the bound program
+void PainterOGL2::uploadPendingUniforms(PainterShaderProgram *program)
+{
+    if(m_dirtyUniforms.none())
+        return;
+
+    const std::vector<int>& locations = resolveUniforms(program);
+    for(size_t handle = 0; handle < locations.size(); ++handle) {
+        if(!m_dirtyUniforms[handle] || locations[handle] < 0)
+            continue;
+
+        const PendingUniform& uniform = m_pendingUniforms[handle];
+        switch(uniform.type) {
+            case PendingUniform::Int32:
+                glUniform1i(locations[handle], uniform.intValue);
+                break;
+            case PendingUniform::Float:
+                glUniform1f(locations[handle], uniform.floatValues[0]);
+                break;
+            case PendingUniform::Vector2:
+                glUniform2fv(locations[handle], 1, uniform.floatValues);
+                break;
+            case PendingUniform::Color4:
+                glUniform4fv(locations[handle], 1, uniform.floatValues);
+                break;
+        }
+        m_renderStats.uniformUploads++;
+    }
+    m_dirtyUniforms.reset();
+}
+
 // Flushes brush configurations by setting outfit values in the shader program
 void PainterOGL2::flushBrushConfigurations(PaintType paintType)
 {
@@ -134,18 +534,20 @@ void PainterOGL2::flushBrushConfigurations(PaintType paintType)
             shaderProgram = m_drawSolidColorProgram.get();
             break;
         case PaintType_Creature:
-            shaderProgram = m_drawCreatureProgram.get();
+            shaderProgram = getCreatureProgram(getCreatureFeatures());
             break;
     }
     
-    // If no shader program is selected, clear the brush configuration vector
+    // If no shader program is selected, drop the queued values
     if(!shaderProgram) {
         m_brushConfigurationVector.clear();
+        m_dirtyUniforms.reset();
         return;
     }
     
-    // Bind the shader program and set outfit values based on brush configurations
-    shaderProgram->bind();
+    // Bind the shader program, upload the queued handles and then any name based brush configurations
+    bindProgram(shaderProgram);
+    uploadPendingUniforms(shaderProgram);
     for(auto& config : m_brushConfigurationVector) {
         switch(config.getType()) {
             case BrushConfiguration::Type_Int32:
@@ -4,6 +4,7 @@
 #define PAINTER_OGL2
 
 #include "painterogl.h"
+#include "streamingvertexbuffer.h"
 
 /**
  * Painter using OpenGL 2.0 programmable rendering pipeline,
@@ -18,6 +19,10 @@ public:
     void bind();
     void unbind();
 
+    void saveState();
+    void saveAndResetState();
+    void restoreSavedState();
+
     void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = Triangles);
     void drawFillCoords(CoordsBuffer& coordsBuffer);
     void drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture);
@@ -30,19 +35,117 @@ public:
 
     void setDrawProgram(PainterShaderProgram *drawProgram) { m_drawProgram = drawProgram; }
 
+    void setTexture(Texture *texture);
+    void setClipRect(const Rect& clipRect);
+    void setColor(const Color& color);
+    void setAlphaWriting(bool enable);
+    void setBlendEquation(BlendEquation blendEquation);
+    void setShaderProgram(PainterShaderProgram *shaderProgram);
+    using Painter::setShaderProgram;
+    void setCompositionMode(CompositionMode compositionMode);
+    void setOpacity(float opacity);
+    void setResolution(const Size& resolution);
+
     void applyPaintType(PaintType paintType);
     void setBrushConfiguration(const BrushConfiguration& brushConfiguration);
     void flushBrushConfigurations(PaintType paintType);
+    void setUniform(UniformHandle handle, int value);
+    void setUniform(UniformHandle handle, float value);
+    void setUniform(UniformHandle handle, const PointF& value);
+    void setUniform(UniformHandle handle, const Color& value);
+    void setOutfitMaskTexture(const TexturePtr& maskTexture);
+    void setShaderFeatures(int features);
+    bool canColorizeOutfits() { return !(m_failedShaderFeatures & ShaderFeature_OutfitColorize); }
 
     bool hasShaders() { return true; }
+    void endFrame() { m_streamBuffer.endFrame(); }
+    // Persistent mapping is chosen when the stream buffer is created, on the first streamed draw
+    void setPersistentStreaming(bool enable) { m_streamBuffer.setPersistentMapping(enable); }
+
+protected:
+    // Painter state fields tracked by the dirty mask
+    enum StateField {
+        StateField_Resolution = 1 << 0,
+        StateField_Color = 1 << 1,
+        StateField_Opacity = 1 << 2,
+        StateField_CompositionMode = 1 << 3,
+        StateField_BlendEquation = 1 << 4,
+        StateField_ClipRect = 1 << 5,
+        StateField_Texture = 1 << 6,
+        StateField_ShaderProgram = 1 << 7,
+        StateField_AlphaWriting = 1 << 8,
+        StateField_ShaderFeatures = 1 << 9
+    };
+    // Snapshot pushed by saveState, along with the fields the enclosing level had changed when it was taken
+    struct SavedState {
+        Size resolution;
+        Matrix3 transformMatrix;
+        Matrix3 projectionMatrix;
+        Matrix3 textureMatrix;
+        Color color;
+        float opacity;
+        CompositionMode compositionMode;
+        BlendEquation blendEquation;
+        Rect clipRect;
+        Texture *texture;
+        PainterShaderProgram *shaderProgram;
+        bool alphaWriting;
+        int shaderFeatures;
+        uint32 dirtyFields;
+    };
+    // Shadow of the uniform values last uploaded to a program, stamped with the painter state versions.
+    // It watches the program so a shadow left by a released program is never used for a new one.
+    struct ProgramUniforms {
+        std::weak_ptr<PainterShaderProgram> program;
+        uint32 colorVersion = 0;
+        uint32 opacityVersion = 0;
+        uint32 resolutionVersion = 0;
+        bool hasMatrices = false;
+        bool hasTextureMatrix = false;
+        Matrix3 transformMatrix;
+        Matrix3 projectionMatrix;
+        Matrix3 textureMatrix;
+        std::vector<int> customLocations;
+    };
+    // Value of a custom uniform waiting for the next flush
+    struct PendingUniform {
+        enum Type { Int32, Float, Vector2, Color4 };
+        Type type;
+        int intValue;
+        float floatValues[4];
+    };
+
+    bool linkProgram(PainterShaderProgram *program, const std::string& vertexSource, const std::string& fragmentSource);
+    PainterShaderProgram *getCreatureProgram(int features);
+    int getCreatureFeatures() { return m_shaderFeatures | (m_outfitMaskTexture ? ShaderFeature_OutfitColorize : 0); }
+    void bindProgram(PainterShaderProgram *program);
+    ProgramUniforms& getProgramUniforms(PainterShaderProgram *program);
+    void uploadUniforms(bool textured);
+    const std::vector<int>& resolveUniforms(PainterShaderProgram *program);
+    void uploadPendingUniforms(PainterShaderProgram *program);
 
-private:
     PainterShaderProgram *m_drawProgram;
+    PainterShaderProgram *m_boundProgram;
+    std::unordered_map<PainterShaderProgram*, ProgramUniforms> m_programUniforms;
+    uint32 m_colorVersion;
+    uint32 m_opacityVersion;
+    uint32 m_resolutionVersion;
+    std::array<PendingUniform, MAX_UNIFORM_HANDLES> m_pendingUniforms;
+    std::bitset<MAX_UNIFORM_HANDLES> m_dirtyUniforms;
+    std::vector<SavedState> m_savedStates;
+    uint32 m_dirtyStateFields;
 
     PainterShaderProgramPtr m_drawTexturedProgram;
     PainterShaderProgramPtr m_drawSolidColorProgram;
 
-    PainterShaderProgramPtr m_drawCreatureProgram;
+    // Creature program variants by feature mask, compiled on first use
+    std::unordered_map<int, PainterShaderProgramPtr> m_creaturePrograms;
+    std::unordered_map<PainterShaderProgram*, int> m_creatureProgramFeatures;
+    int m_shaderFeatures;
+    int m_failedShaderFeatures;
+
+    TexturePtr m_outfitMaskTexture;
+    StreamingVertexBuffer m_streamBuffer;
 };
 
 extern PainterOGL2 *g_painterOGL2;
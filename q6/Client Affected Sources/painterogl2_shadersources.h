@@ -59,30 +59,34 @@ static const std::string glslSolidColorFragmentShader = "\n\
         return u_Color;\n\
     }\n";
 
-// Fragment shader for rendering creatures with a special effect when dashing.
-// It checks if the creature is dashing and applies a red highlight if so.
+// Fragment shader for rendering creatures, compiled once per combination of creature features.
+// Every feature is a preprocessor toggle, so a variant only carries the code of the features it uses.
+// OUTFIT_COLORIZE: u_Tex1 holds the raw color mask of the frame, yellow marks the head, red the body,
+// green the legs and blue the feet. Each region multiplies the base by its outfit color in the same pass.
 static const std::string glslCreatureSrcFragmentShader = "\n\
     varying mediump vec2 v_TexCoord;\n\
     outfit lowp vec4 u_Color;\n\
     outfit sampler2D u_Tex0;\n\
-    outfit int u_IsDashing;\n\
+    #ifdef OUTFIT_COLORIZE\n\
+    outfit sampler2D u_Tex1;\n\
+    outfit lowp vec4 u_HeadColor;\n\
+    outfit lowp vec4 u_BodyColor;\n\
+    outfit lowp vec4 u_LegsColor;\n\
+    outfit lowp vec4 u_FeetColor;\n\
+    #endif\n\
     lowp vec4 calculatePixel() {\n\
-        if(u_IsDashing == 0) {\n\
-            return texture2D(u_Tex0, v_TexCoord) * u_Color;\n\
-        }\n\
-        else {\n\
-            ivec2 textureSize = textureSize(u_Tex0, 0);\n\
-            vec2 texelSize = vec2(1.0/float(textureSize.x), 1.0/float(textureSize.y));\n\
-            float alpha = 0.0;\n\
-            alpha = max(alpha, texture2D(u_Tex0, v_TexCoord + vec2(-texelSize.x, 0.0)).a);\n\
-            alpha = max(alpha, texture2D(u_Tex0, v_TexCoord + vec2(texelSize.x, 0.0)).a);\n\
-            alpha = max(alpha, texture2D(u_Tex0, v_TexCoord + vec2(0.0, -texelSize.y)).a);\n\
-            alpha = max(alpha, texture2D(u_Tex0, v_TexCoord + vec2(0.0, texelSize.y)).a);\n\
-            if(alpha == 0.0)\n\
-                return vec4(0.0, 0.0, 0.0, 0.0);\n\
-            else\n\
-                return vec4(1.0, 0.0, 0.0, 1.0);\n\
-        }\n\
+        lowp vec4 pixel = texture2D(u_Tex0, v_TexCoord) * u_Color;\n\
+    #ifdef OUTFIT_COLORIZE\n\
+        lowp vec4 mask = texture2D(u_Tex1, v_TexCoord);\n\
+        lowp vec3 inv = vec3(1.0) - mask.rgb;\n\
+        lowp vec4 tint = vec4(1.0);\n\
+        tint = mix(tint, u_HeadColor, mask.a * mask.r * mask.g * inv.b);\n\
+        tint = mix(tint, u_BodyColor, mask.a * mask.r * inv.g * inv.b);\n\
+        tint = mix(tint, u_LegsColor, mask.a * mask.g * inv.r * inv.b);\n\
+        tint = mix(tint, u_FeetColor, mask.a * mask.b * inv.r * inv.g);\n\
+        pixel *= tint;\n\
+    #endif\n\
+        return pixel;\n\
     }\n";
 
 #endif
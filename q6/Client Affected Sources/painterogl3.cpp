@@ -0,0 +1,238 @@
+#include "painterogl3.h"
+#include "painterogl3_shadersources.h"
+
+#ifdef PAINTER_OGL3
+
+// Global pointer to the PainterOGL3 instance
+PainterOGL3 *g_painterOGL3 = nullptr;
+
+// Constructor for the PainterOGL3 class, builds the instanced program and its vertex array
+PainterOGL3::PainterOGL3()
+{
+    m_drawInstancedProgram = std::make_shared<PainterShaderProgram>();
+    assert(m_drawInstancedProgram);
+
+    // Instance attributes need fixed locations so the vertex array can be recorded once
+    m_drawInstancedProgram->bindAttributeLocation(DEST_RECT_ATTR, "a_DestRect");
+    m_drawInstancedProgram->bindAttributeLocation(SRC_RECT_ATTR, "a_SrcRect");
+    m_drawInstancedProgram->bindAttributeLocation(COLOR_ATTR, "a_Color");
+    linkProgram(m_drawInstancedProgram.get(), glslInstancedQuadVertexShader, glslInstancedQuadFragmentShader);
+    resolveUniforms(m_drawInstancedProgram.get());
+
+    glGenVertexArrays(1, &m_vertexArray);
+    glBindVertexArray(m_vertexArray);
+
+    // Corners of the unit quad, in triangle strip order
+    static const float quad[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+    glGenBuffers(1, &m_quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(PainterShaderProgram::VERTEX_ATTR);
+    glVertexAttribPointer(PainterShaderProgram::VERTEX_ATTR, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    // Instance records advance once per quad
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, MAX_INSTANCES * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    const std::pair<int, size_t> instanceAttributes[] = {
+        { DEST_RECT_ATTR, offsetof(Instance, destRect) },
+        { SRC_RECT_ATTR, offsetof(Instance, srcRect) },
+        { COLOR_ATTR, offsetof(Instance, color) }
+    };
+    for(const auto& attribute : instanceAttributes) {
+        glEnableVertexAttribArray(attribute.first);
+        glVertexAttribPointer(attribute.first, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<const void*>(attribute.second));
+        glVertexAttribDivisor(attribute.first, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_instances.reserve(MAX_INSTANCES);
+}
+
+PainterOGL3::~PainterOGL3()
+{
+    glDeleteBuffers(1, &m_instanceBuffer);
+    glDeleteBuffers(1, &m_quadBuffer);
+    glDeleteVertexArrays(1, &m_vertexArray);
+}
+
+// Checks if the current context can run this painter, called at startup to pick it over PainterOGL2
+bool PainterOGL3::isSupported()
+{
+#ifdef OPENGL_ES
+    return true;
+#else
+    return GLEW_VERSION_3_3;
+#endif
+}
+
+void PainterOGL3::unbind()
+{
+    flush();
+    PainterOGL2::unbind();
+}
+
+// Resets happen around framebuffer binds, the queued quads belong to the previous target. Plain saves and
+// restores go through the setters below, so they only flush when a restored field really differs
+void PainterOGL3::saveAndResetState()
+{
+    flush();
+    PainterOGL2::saveAndResetState();
+}
+
+void PainterOGL3::clear(const Color& color)
+{
+    flush();
+    PainterOGL2::clear(color);
+}
+
+// Arbitrary coords keep the PainterOGL2 path, drawn after the quads queued before them
+void PainterOGL3::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
+{
+    flush();
+    PainterOGL2::drawCoords(coordsBuffer, drawMode);
+}
+
+// Queues a textured quad as one instance when the default textured program would draw it
+void PainterOGL3::drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    if(dest.isEmpty() || src.isEmpty() || texture->isEmpty())
+        return;
+
+    // Custom shaders and the creature programs read their own vertex layout
+    if(m_shaderProgram && m_shaderProgram != m_drawTexturedProgram.get()) {
+        PainterOGL2::drawTexturedRect(dest, texture, src);
+        return;
+    }
+
+    setTexture(texture.get());
+    if((int)m_instances.size() == MAX_INSTANCES)
+        flush();
+
+    // Color and opacity travel with the instance, so changing them never breaks a batch
+    m_instances.push_back(Instance{
+        { (float)dest.left(), (float)dest.top(), (float)dest.width(), (float)dest.height() },
+        { (float)src.left(), (float)src.top(), (float)src.width(), (float)src.height() },
+        { m_color.rF(), m_color.gF(), m_color.bF(), m_color.aF() * m_opacity }
+    });
+}
+
+// Every setter below changes state the queued quads were recorded with, so they are drawn first
+void PainterOGL3::setTexture(Texture *texture)
+{
+    if(texture != m_texture)
+        flush();
+    PainterOGL2::setTexture(texture);
+}
+
+void PainterOGL3::setClipRect(const Rect& clipRect)
+{
+    if(clipRect != m_clipRect)
+        flush();
+    PainterOGL2::setClipRect(clipRect);
+}
+
+void PainterOGL3::setAlphaWriting(bool enable)
+{
+    if(enable != m_alphaWriting)
+        flush();
+    PainterOGL2::setAlphaWriting(enable);
+}
+
+void PainterOGL3::setBlendEquation(BlendEquation blendEquation)
+{
+    if(blendEquation != m_blendEquation)
+        flush();
+    PainterOGL2::setBlendEquation(blendEquation);
+}
+
+void PainterOGL3::setShaderProgram(PainterShaderProgram *shaderProgram)
+{
+    if(shaderProgram != m_shaderProgram)
+        flush();
+    PainterOGL2::setShaderProgram(shaderProgram);
+}
+
+void PainterOGL3::setCompositionMode(CompositionMode compositionMode)
+{
+    if(compositionMode != m_compositionMode)
+        flush();
+    PainterOGL2::setCompositionMode(compositionMode);
+}
+
+void PainterOGL3::setResolution(const Size& resolution)
+{
+    flush();
+    PainterOGL2::setResolution(resolution);
+}
+
+void PainterOGL3::scale(float x, float y)
+{
+    flush();
+    PainterOGL2::scale(x, y);
+}
+
+void PainterOGL3::translate(float x, float y)
+{
+    flush();
+    PainterOGL2::translate(x, y);
+}
+
+void PainterOGL3::rotate(float angle)
+{
+    flush();
+    PainterOGL2::rotate(angle);
+}
+
+void PainterOGL3::rotate(float x, float y, float angle)
+{
+    flush();
+    PainterOGL2::rotate(x, y, angle);
+}
+
+void PainterOGL3::pushTransformMatrix()
+{
+    flush();
+    PainterOGL2::pushTransformMatrix();
+}
+
+void PainterOGL3::popTransformMatrix()
+{
+    flush();
+    PainterOGL2::popTransformMatrix();
+}
+
+// Draws every queued quad with one instanced call
+void PainterOGL3::flush()
+{
+    if(m_instances.empty())
+        return;
+
+    PainterShaderProgram *previousProgram = m_drawProgram;
+    m_drawProgram = m_drawInstancedProgram.get();
+    bindProgram(m_drawProgram);
+    uploadUniforms(true);
+    m_drawProgram->bindMultiTextures();
+
+    // Orphan the instance storage so the upload never waits on the previous batch
+    glBindVertexArray(m_vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, MAX_INSTANCES * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(Instance), m_instances.data());
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_instances.size());
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_renderStats.drawCalls++;
+    m_instances.clear();
+    m_drawProgram = previousProgram;
+}
+
+void PainterOGL3::endFrame()
+{
+    flush();
+    PainterOGL2::endFrame();
+}
+
+#endif
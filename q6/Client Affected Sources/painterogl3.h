@@ -0,0 +1,83 @@
+#ifndef PAINTEROGL3_H
+#define PAINTEROGL3_H
+
+#include "painterogl2.h"
+
+#if !defined(OPENGL_ES) || OPENGL_ES >= 3
+
+#define PAINTER_OGL3
+
+/**
+ * Painter for OpenGL 3.3 and OpenGL ES 3.0 contexts. Plain textured quads
+ * are queued as one instance record each and drawn with a single
+ * instanced call per run of quads sharing texture and render state, from
+ * a vertex array object holding a static unit quad. Everything else (custom
+ * shaders, creature programs, solid fills, arbitrary coords) goes through
+ * PainterOGL2 after the queued quads are flushed.
+ */
+class PainterOGL3 : public PainterOGL2
+{
+public:
+    enum {
+        DEST_RECT_ATTR = 2,
+        SRC_RECT_ATTR = 3,
+        COLOR_ATTR = 4,
+        MAX_INSTANCES = 4096
+    };
+
+    PainterOGL3();
+    ~PainterOGL3();
+
+    static bool isSupported();
+
+    void unbind();
+
+    void saveAndResetState();
+
+    void clear(const Color& color);
+
+    void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = Triangles);
+    void drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+
+    void setTexture(Texture *texture);
+    void setClipRect(const Rect& clipRect);
+    void setAlphaWriting(bool enable);
+    void setBlendEquation(BlendEquation blendEquation);
+    void setShaderProgram(PainterShaderProgram *shaderProgram);
+    void setCompositionMode(CompositionMode compositionMode);
+    void setResolution(const Size& resolution);
+
+    void scale(float x, float y);
+    void translate(float x, float y);
+    void rotate(float angle);
+    void rotate(float x, float y, float angle);
+    void pushTransformMatrix();
+    void popTransformMatrix();
+
+    void flush();
+    void endFrame();
+
+    bool canBatchTexturedRects() { return !m_shaderProgram || m_shaderProgram == m_drawTexturedProgram.get(); }
+
+    int getInstanceCount() { return m_instances.size(); }
+
+private:
+    // One queued quad, laid out as the instanced vertex attributes read it
+    struct Instance {
+        float destRect[4];
+        float srcRect[4];
+        float color[4];
+    };
+
+    uint m_vertexArray;
+    uint m_quadBuffer;
+    uint m_instanceBuffer;
+    PainterShaderProgramPtr m_drawInstancedProgram;
+    std::vector<Instance> m_instances;
+};
+
+extern PainterOGL3 *g_painterOGL3;
+
+#endif
+
+#endif
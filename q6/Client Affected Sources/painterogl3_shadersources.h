@@ -0,0 +1,37 @@
+#ifndef PAINTEROGL3_SHADERSOURCES_H
+#define PAINTEROGL3_SHADERSOURCES_H
+
+// GLSL sources of the instanced quad program used by PainterOGL3.
+// Every quad is one instance: a_Vertex walks the corners of a unit quad and the per instance
+// attributes place it on the screen and in the texture.
+
+// Vertex shader expanding one instance record into a textured quad.
+static const std::string glslInstancedQuadVertexShader = "\n\
+    attribute highp vec2 a_Vertex;\n\
+    attribute highp vec4 a_DestRect;\n\
+    attribute highp vec4 a_SrcRect;\n\
+    attribute lowp vec4 a_Color;\n\
+    outfit highp mat3 u_TransformMatrix;\n\
+    outfit highp mat3 u_ProjectionMatrix;\n\
+    outfit highp mat3 u_TextureMatrix;\n\
+    varying highp vec2 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    void main()\n\
+    {\n\
+        highp vec2 position = a_DestRect.xy + a_Vertex * a_DestRect.zw;\n\
+        gl_Position = vec4(u_ProjectionMatrix * u_TransformMatrix * vec3(position, 1.0), 1.0);\n\
+        v_TexCoord = (u_TextureMatrix * vec3(a_SrcRect.xy + a_Vertex * a_SrcRect.zw, 1.0)).xy;\n\
+        v_Color = a_Color;\n\
+    }\n";
+
+// Fragment shader tinting the texture by the instance color, which already carries the opacity.
+static const std::string glslInstancedQuadFragmentShader = "\n\
+    varying mediump vec2 v_TexCoord;\n\
+    varying lowp vec4 v_Color;\n\
+    outfit sampler2D u_Tex0;\n\
+    void main()\n\
+    {\n\
+        gl_FragColor = texture2D(u_Tex0, v_TexCoord) * v_Color;\n\
+    }\n";
+
+#endif
@@ -0,0 +1,443 @@
+#include "softwarepainter.h"
+#include "image.h"
+
+// Constructor for the SoftwarePainter class, the target image starts fully transparent
+SoftwarePainter::SoftwarePainter(const Size& size)
+    : m_fragments(0)
+{
+    m_image = ImagePtr(new Image(size));
+    m_resolution = size;
+    resetState();
+}
+
+void SoftwarePainter::saveState()
+{
+    m_savedStates.push_back(State{m_transform, m_color, m_opacity, m_compositionMode, m_blendEquation, m_clipRect, m_shaderProgram, m_texture, m_alphaWriting});
+}
+
+void SoftwarePainter::saveAndResetState()
+{
+    saveState();
+    resetState();
+}
+
+void SoftwarePainter::restoreSavedState()
+{
+    if (m_savedStates.empty())
+        return;
+
+    const State& state = m_savedStates.back();
+    m_transform = state.transform;
+    m_color = state.color;
+    m_opacity = state.opacity;
+    m_compositionMode = state.compositionMode;
+    m_blendEquation = state.blendEquation;
+    m_clipRect = state.clipRect;
+    m_shaderProgram = state.shaderProgram;
+    m_texture = state.texture;
+    m_alphaWriting = state.alphaWriting;
+    m_savedStates.pop_back();
+}
+
+// Fills the scissor area like glClear does, ignoring blending
+void SoftwarePainter::clear(const Color& color)
+{
+    Rect scissor = getScissor();
+    uint8 *pixels = m_image->getPixelData();
+    int width = m_image->getSize().width();
+    for (int y = scissor.top(); y <= scissor.bottom(); ++y) {
+        for (int x = scissor.left(); x <= scissor.right(); ++x) {
+            uint8 *pixel = pixels + (y * width + x) * 4;
+            pixel[0] = color.r();
+            pixel[1] = color.g();
+            pixel[2] = color.b();
+            if (m_alphaWriting)
+                pixel[3] = color.a();
+        }
+    }
+}
+
+void SoftwarePainter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
+{
+    bool textured = coordsBuffer.getTextureCoordCount() > 0 && m_texture;
+    drawTriangles(coordsBuffer.getVertexArray(), textured ? coordsBuffer.getTextureCoordArray() : nullptr, coordsBuffer.getVertexCount(), drawMode);
+}
+
+void SoftwarePainter::drawFillCoords(CoordsBuffer& coordsBuffer)
+{
+    drawTriangles(coordsBuffer.getVertexArray(), nullptr, coordsBuffer.getVertexCount(), Triangles);
+}
+
+void SoftwarePainter::drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture)
+{
+    if (!texture || texture->isEmpty())
+        return;
+
+    setTexture(texture.get());
+    drawTriangles(coordsBuffer.getVertexArray(), coordsBuffer.getTextureCoordArray(), coordsBuffer.getVertexCount(), Triangles);
+}
+
+void SoftwarePainter::drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    if (dest.isEmpty() || src.isEmpty() || !texture || texture->isEmpty())
+        return;
+
+    setTexture(texture.get());
+    drawQuad(dest, src, true, false);
+}
+
+void SoftwarePainter::drawUpsideDownTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    if (dest.isEmpty() || src.isEmpty() || !texture || texture->isEmpty())
+        return;
+
+    setTexture(texture.get());
+    drawQuad(dest, src, true, true);
+}
+
+// Tiles the source over the destination, cutting the last row and column like CoordsBuffer::addRepeatedRects
+void SoftwarePainter::drawRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src)
+{
+    if (dest.isEmpty() || src.isEmpty() || !texture || texture->isEmpty())
+        return;
+
+    setTexture(texture.get());
+    for (int y = 0; y < dest.height(); y += src.height()) {
+        for (int x = 0; x < dest.width(); x += src.width()) {
+            Size size(std::min<int>(src.width(), dest.width() - x), std::min<int>(src.height(), dest.height() - y));
+            drawQuad(Rect(dest.topLeft() + Point(x, y), size), Rect(src.topLeft(), size), true, false);
+        }
+    }
+}
+
+void SoftwarePainter::drawFilledRect(const Rect& dest)
+{
+    if (dest.isEmpty())
+        return;
+    drawQuad(dest, Rect(), false, false);
+}
+
+void SoftwarePainter::drawFilledTriangle(const Point& a, const Point& b, const Point& c)
+{
+    if (a == b || a == c || b == c)
+        return;
+
+    const float vertices[] = { (float)a.x, (float)a.y, (float)b.x, (float)b.y, (float)c.x, (float)c.y };
+    drawTriangles(vertices, nullptr, 3, Triangles);
+}
+
+// Draws the border of a rect as four filled rects, innerLineWidth pixels thick
+void SoftwarePainter::drawBoundingRect(const Rect& dest, int innerLineWidth)
+{
+    if (dest.isEmpty() || innerLineWidth == 0)
+        return;
+
+    int w = std::min<int>(innerLineWidth, dest.width());
+    int h = std::min<int>(innerLineWidth, dest.height());
+    drawQuad(Rect(dest.left(), dest.top(), dest.width(), h), Rect(), false, false);
+    drawQuad(Rect(dest.left(), dest.bottom() - h + 1, dest.width(), h), Rect(), false, false);
+    if (dest.height() > 2 * h) {
+        drawQuad(Rect(dest.left(), dest.top() + h, w, dest.height() - 2 * h), Rect(), false, false);
+        drawQuad(Rect(dest.right() - w + 1, dest.top() + h, w, dest.height() - 2 * h), Rect(), false, false);
+    }
+}
+
+void SoftwarePainter::setResolution(const Size& resolution)
+{
+    m_resolution = resolution;
+}
+
+// Keeps the outfit colors of the colorize program, the only custom uniforms it emulates
+void SoftwarePainter::setUniform(UniformHandle handle, const Color& value)
+{
+    static const UniformHandle outfitHandles[] = {
+        declareUniform("u_HeadColor"), declareUniform("u_BodyColor"), declareUniform("u_LegsColor"), declareUniform("u_FeetColor")
+    };
+    if (!isValidUniform(handle))
+        return;
+
+    for (int i = 0; i < 4; ++i) {
+        if (outfitHandles[i] == handle)
+            m_outfitColors[i] = value;
+    }
+}
+
+void SoftwarePainter::scale(float x, float y)
+{
+    m_transform.a *= x;
+    m_transform.b *= x;
+    m_transform.c *= y;
+    m_transform.d *= y;
+}
+
+void SoftwarePainter::translate(float x, float y)
+{
+    m_transform.tx += m_transform.a * x + m_transform.c * y;
+    m_transform.ty += m_transform.b * x + m_transform.d * y;
+}
+
+void SoftwarePainter::rotate(float angle)
+{
+    float cosine = std::cos(angle);
+    float sine = std::sin(angle);
+    Transform t = m_transform;
+    m_transform.a = t.a * cosine + t.c * sine;
+    m_transform.b = t.b * cosine + t.d * sine;
+    m_transform.c = t.c * cosine - t.a * sine;
+    m_transform.d = t.d * cosine - t.b * sine;
+}
+
+// Same composition as PainterOGL::rotate(x, y, angle)
+void SoftwarePainter::rotate(float x, float y, float angle)
+{
+    translate(-x, -y);
+    rotate(angle);
+    translate(x, y);
+}
+
+void SoftwarePainter::pushTransformMatrix()
+{
+    m_transformStack.push_back(m_transform);
+}
+
+void SoftwarePainter::popTransformMatrix()
+{
+    if (m_transformStack.empty())
+        return;
+
+    m_transform = m_transformStack.back();
+    m_transformStack.pop_back();
+}
+
+// Registers the pixels sampled for a texture, images have to outlive their use or be replaced
+void SoftwarePainter::setTextureImage(Texture *texture, const ImagePtr& image)
+{
+    if (image)
+        m_textureImages[texture] = image;
+    else
+        m_textureImages.erase(texture);
+}
+
+// FNV-1a hash of the target pixels, a cheap key for golden image comparisons
+uint64 SoftwarePainter::getImageHash()
+{
+    const uint8 *pixels = m_image->getPixelData();
+    size_t size = m_image->getSize().area() * 4;
+
+    uint64 hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= pixels[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void SoftwarePainter::resetState()
+{
+    m_transform = Transform();
+    m_color = Color::white;
+    m_opacity = 1.0f;
+    m_compositionMode = CompositionMode_Normal;
+    m_blendEquation = BlendEquation_Add;
+    m_clipRect = Rect();
+    m_shaderProgram = nullptr;
+    m_texture = nullptr;
+    m_alphaWriting = false;
+}
+
+// Splits a rect in two triangles the way CoordsBuffer::addRect and addQuad do
+void SoftwarePainter::drawQuad(const Rect& dest, const Rect& src, bool textured, bool upsideDown)
+{
+    float left = dest.left(), top = dest.top(), right = dest.right() + 1, bottom = dest.bottom() + 1;
+    float srcLeft = src.left(), srcTop = src.top(), srcRight = src.right() + 1, srcBottom = src.bottom() + 1;
+    if (upsideDown)
+        std::swap(srcTop, srcBottom);
+
+    const float vertices[] = { left, top, right, top, left, bottom, right, bottom };
+    const float texCoords[] = { srcLeft, srcTop, srcRight, srcTop, srcLeft, srcBottom, srcRight, srcBottom };
+    drawTriangles(vertices, textured ? texCoords : nullptr, 4, TriangleStrip);
+}
+
+void SoftwarePainter::drawTriangles(const float *vertices, const float *texCoords, int vertexCount, DrawMode drawMode)
+{
+    if (vertexCount < 3)
+        return;
+
+    // The creature program samples the outfit mask on the second unit
+    ImagePtr texture = texCoords ? getTextureImage(m_texture) : nullptr;
+    if (texCoords && !texture)
+        return;
+    ImagePtr mask = texture && m_paintType == PaintType_Creature && m_outfitMaskTexture ? getTextureImage(m_outfitMaskTexture.get()) : nullptr;
+
+    m_renderStats.drawCalls++;
+    auto vertex = [&](int i) { return m_transform.map(vertices[i * 2], vertices[i * 2 + 1]); };
+    auto texCoord = [&](int i) { return texCoords ? PointF(texCoords[i * 2], texCoords[i * 2 + 1]) : PointF(0, 0); };
+
+    if (drawMode == TriangleStrip) {
+        for (int i = 0; i + 2 < vertexCount; ++i)
+            rasterizeTriangle(vertex(i), vertex(i + 1), vertex(i + 2), texCoord(i), texCoord(i + 1), texCoord(i + 2), texture, mask);
+    } else {
+        for (int i = 0; i + 2 < vertexCount; i += 3)
+            rasterizeTriangle(vertex(i), vertex(i + 1), vertex(i + 2), texCoord(i), texCoord(i + 1), texCoord(i + 2), texture, mask);
+    }
+}
+
+// Rasterizes a triangle sampling at pixel centers, pixels on a shared edge belong to one triangle only (top-left rule)
+void SoftwarePainter::rasterizeTriangle(PointF v0, PointF v1, PointF v2, PointF t0, PointF t1, PointF t2, const ImagePtr& texture, const ImagePtr& mask)
+{
+    auto edge = [](const PointF& a, const PointF& b, float x, float y) { return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x); };
+
+    float area = edge(v0, v1, v2.x, v2.y);
+    if (area == 0)
+        return;
+    if (area < 0) {
+        std::swap(v1, v2);
+        std::swap(t1, t2);
+        area = -area;
+    }
+
+    // With positive area the interior lies below top edges and right of left edges
+    auto isTopLeft = [](const PointF& a, const PointF& b) { return (a.y == b.y && b.x > a.x) || b.y < a.y; };
+    bool topLeft0 = isTopLeft(v1, v2), topLeft1 = isTopLeft(v2, v0), topLeft2 = isTopLeft(v0, v1);
+
+    Rect scissor = getScissor();
+    int minX = std::max<int>(scissor.left(), std::floor(std::min({v0.x, v1.x, v2.x})));
+    int maxX = std::min<int>(scissor.right(), std::ceil(std::max({v0.x, v1.x, v2.x})));
+    int minY = std::max<int>(scissor.top(), std::floor(std::min({v0.y, v1.y, v2.y})));
+    int maxY = std::min<int>(scissor.bottom(), std::ceil(std::max({v0.y, v1.y, v2.y})));
+
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            float px = x + 0.5f, py = y + 0.5f;
+            float w0 = edge(v1, v2, px, py);
+            float w1 = edge(v2, v0, px, py);
+            float w2 = edge(v0, v1, px, py);
+            if (w0 < 0 || w1 < 0 || w2 < 0)
+                continue;
+            if ((w0 == 0 && !topLeft0) || (w1 == 0 && !topLeft1) || (w2 == 0 && !topLeft2))
+                continue;
+
+            float u = (w0 * t0.x + w1 * t1.x + w2 * t2.x) / area;
+            float v = (w0 * t0.y + w1 * t1.y + w2 * t2.y) / area;
+            shadeFragment(x, y, u, v, texture, mask);
+        }
+    }
+}
+
+// Runs the emulated fragment program and blends the result like PainterOGL configures GL blending
+void SoftwarePainter::shadeFragment(int x, int y, float u, float v, const ImagePtr& texture, const ImagePtr& mask)
+{
+    m_fragments++;
+
+    auto sample = [](const ImagePtr& image, float u, float v, float *out) {
+        const Size& size = image->getSize();
+        int sx = std::max<int>(0, std::min<int>(size.width() - 1, std::floor(u)));
+        int sy = std::max<int>(0, std::min<int>(size.height() - 1, std::floor(v)));
+        const uint8 *texel = image->getPixelData() + (sy * size.width() + sx) * 4;
+        for (int i = 0; i < 4; ++i)
+            out[i] = texel[i] / 255.0f;
+    };
+
+    float src[4] = { m_color.rF(), m_color.gF(), m_color.bF(), m_color.aF() };
+    if (texture) {
+        float texel[4];
+        sample(texture, u, v, texel);
+        for (int i = 0; i < 4; ++i)
+            src[i] *= texel[i];
+
+        // Same region weights as glslCreatureColorizeSrcFragmentShader
+        if (mask) {
+            float m[4];
+            sample(mask, u, v, m);
+            float weights[4] = {
+                m[3] * m[0] * m[1] * (1 - m[2]),
+                m[3] * m[0] * (1 - m[1]) * (1 - m[2]),
+                m[3] * m[1] * (1 - m[0]) * (1 - m[2]),
+                m[3] * m[2] * (1 - m[0]) * (1 - m[1])
+            };
+            float tint[4] = { 1, 1, 1, 1 };
+            for (int region = 0; region < 4; ++region) {
+                const Color& color = m_outfitColors[region];
+                const float regionColor[4] = { color.rF(), color.gF(), color.bF(), color.aF() };
+                for (int i = 0; i < 4; ++i)
+                    tint[i] += (regionColor[i] - tint[i]) * weights[region];
+            }
+            for (int i = 0; i < 4; ++i)
+                src[i] *= tint[i];
+        }
+    }
+    src[3] *= m_opacity;
+
+    uint8 *pixel = m_image->getPixelData() + (y * m_image->getSize().width() + x) * 4;
+    float dst[4];
+    for (int i = 0; i < 4; ++i)
+        dst[i] = pixel[i] / 255.0f;
+
+    float out[4];
+    for (int i = 0; i < 4; ++i) {
+        if (m_blendEquation == BlendEquation_Max) {
+            out[i] = std::max<float>(src[i], dst[i]);
+            continue;
+        }
+
+        bool alpha = i == 3;
+        float srcFactor, dstFactor;
+        switch (m_compositionMode) {
+            case CompositionMode_Normal:
+                srcFactor = alpha ? 1.0f : src[3];
+                dstFactor = 1.0f - src[3];
+                break;
+            case CompositionMode_Multiply:
+                srcFactor = dst[i];
+                dstFactor = 1.0f - src[3];
+                break;
+            case CompositionMode_Add:
+                srcFactor = 1.0f - src[i];
+                dstFactor = 1.0f - src[i];
+                break;
+            case CompositionMode_Replace:
+                srcFactor = 1.0f;
+                dstFactor = 0.0f;
+                break;
+            case CompositionMode_DestBlending:
+                srcFactor = 1.0f - dst[3];
+                dstFactor = dst[3];
+                break;
+            case CompositionMode_Light:
+                srcFactor = 0.0f;
+                dstFactor = src[i];
+                break;
+            default:
+                srcFactor = 1.0f;
+                dstFactor = 0.0f;
+                break;
+        }
+        out[i] = src[i] * srcFactor + dst[i] * dstFactor;
+    }
+
+    int channels = m_alphaWriting ? 4 : 3;
+    for (int i = 0; i < channels; ++i)
+        pixel[i] = (uint8)std::round(std::max<float>(0.0f, std::min<float>(1.0f, out[i])) * 255.0f);
+}
+
+const ImagePtr& SoftwarePainter::getTextureImage(Texture *texture)
+{
+    static const ImagePtr none;
+    if (!texture)
+        return none;
+
+    auto it = m_textureImages.find(texture);
+    if (it != m_textureImages.end())
+        return it->second;
+
+    if (!m_textureSource)
+        return none;
+    return m_textureImages[texture] = m_textureSource(texture);
+}
+
+// The clip rect limited to the target, the whole target when no clip is set
+Rect SoftwarePainter::getScissor()
+{
+    Rect target(Point(0, 0), m_image->getSize());
+    return m_clipRect.isValid() ? m_clipRect.intersection(target) : target;
+}
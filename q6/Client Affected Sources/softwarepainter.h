@@ -0,0 +1,108 @@
+#ifndef SOFTWAREPAINTER_H
+#define SOFTWAREPAINTER_H
+
+#include "painter.h"
+
+/**
+ * Painter rasterizing on the CPU into an in-memory image, for golden image
+ * comparisons and draw benchmarks on machines without a GPU. It follows
+ * the PainterOGL2 pipeline: transforms, clip rects, the composition modes
+ * and blend equations as PainterOGL maps them to GL blend state, alpha
+ * writing, opacity, and the single pass outfit colorize program. Sampling
+ * is nearest and triangles follow the top-left fill rule, so output is
+ * deterministic. Texture pixels are taken from images registered per
+ * texture or from a texture source callback, since GPU textures can not be
+ * read back here.
+ */
+class SoftwarePainter : public Painter
+{
+public:
+    typedef std::function<ImagePtr(Texture*)> TextureSource;
+
+    SoftwarePainter(const Size& size);
+
+    void saveState();
+    void saveAndResetState();
+    void restoreSavedState();
+
+    void clear(const Color& color);
+
+    void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = Triangles);
+    void drawFillCoords(CoordsBuffer& coordsBuffer);
+    void drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture);
+    void drawTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+    void drawUpsideDownTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+    void drawRepeatedTexturedRect(const Rect& dest, const TexturePtr& texture, const Rect& src);
+    void drawFilledRect(const Rect& dest);
+    void drawFilledTriangle(const Point& a, const Point& b, const Point& c);
+    void drawBoundingRect(const Rect& dest, int innerLineWidth = 1);
+
+    void setTexture(Texture *texture) { m_texture = texture; }
+    void setClipRect(const Rect& clipRect) { m_clipRect = clipRect; }
+    void setAlphaWriting(bool enable) { m_alphaWriting = enable; }
+    void setBlendEquation(BlendEquation blendEquation) { m_blendEquation = blendEquation; }
+    void setCompositionMode(CompositionMode compositionMode) { m_compositionMode = compositionMode; }
+    void setResolution(const Size& resolution);
+
+    void applyPaintType(PaintType paintType) { m_paintType = paintType; }
+    void setOutfitMaskTexture(const TexturePtr& maskTexture) { m_outfitMaskTexture = maskTexture; }
+    bool canColorizeOutfits() { return true; }
+    void setUniform(UniformHandle handle, const Color& value);
+
+    void scale(float x, float y);
+    void translate(float x, float y);
+    void rotate(float angle);
+    void rotate(float x, float y, float angle);
+    void pushTransformMatrix();
+    void popTransformMatrix();
+
+    bool hasShaders() { return false; }
+
+    void setTextureImage(Texture *texture, const ImagePtr& image);
+    void setTextureSource(const TextureSource& source) { m_textureSource = source; }
+
+    const ImagePtr& getImage() { return m_image; }
+    uint64 getImageHash();
+    uint64 getFragmentCount() { return m_fragments; }
+
+private:
+    // Affine transform, x' = a * x + c * y + tx and y' = b * x + d * y + ty
+    struct Transform {
+        float a = 1, b = 0, c = 0, d = 1, tx = 0, ty = 0;
+        PointF map(float x, float y) const { return PointF(a * x + c * y + tx, b * x + d * y + ty); }
+    };
+    struct State {
+        Transform transform;
+        Color color;
+        float opacity;
+        CompositionMode compositionMode;
+        BlendEquation blendEquation;
+        Rect clipRect;
+        PainterShaderProgram *shaderProgram;
+        Texture *texture;
+        bool alphaWriting;
+    };
+
+    void resetState();
+    void drawQuad(const Rect& dest, const Rect& src, bool textured, bool upsideDown);
+    void drawTriangles(const float *vertices, const float *texCoords, int vertexCount, DrawMode drawMode);
+    void rasterizeTriangle(PointF v0, PointF v1, PointF v2, PointF t0, PointF t1, PointF t2, const ImagePtr& texture, const ImagePtr& mask);
+    void shadeFragment(int x, int y, float u, float v, const ImagePtr& texture, const ImagePtr& mask);
+    const ImagePtr& getTextureImage(Texture *texture);
+    Rect getScissor();
+
+    ImagePtr m_image;
+    Transform m_transform;
+    std::vector<Transform> m_transformStack;
+    std::vector<State> m_savedStates;
+    Texture *m_texture;
+    TexturePtr m_outfitMaskTexture;
+    BlendEquation m_blendEquation;
+    bool m_alphaWriting;
+    std::array<Color, 4> m_outfitColors;
+    std::unordered_map<Texture*, ImagePtr> m_textureImages;
+    TextureSource m_textureSource;
+    uint64 m_fragments;
+};
+
+#endif
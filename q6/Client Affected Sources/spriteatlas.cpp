@@ -0,0 +1,290 @@
+#include "spriteatlas.h"
+#include "spritemanager.h"
+#include "thingtype.h"
+
+#include <framework/core/eventdispatcher.h>
+#include <framework/graphics/glutil.h>
+#include <framework/graphics/painter.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/texture.h>
+
+// Global instance of the sprite atlas
+SpriteAtlas g_spriteAtlas;
+
+// Constructor for the SpriteAtlas class
+SpriteAtlas::SpriteAtlas()
+    : m_maxPages(DEFAULT_MAX_PAGES), m_hits(0), m_misses(0), m_evictions(0) {}
+
+// Stops the periodic defragmentation and releases the pages
+void SpriteAtlas::terminate()
+{
+    if (m_defragEvent) {
+        m_defragEvent->cancel();
+        m_defragEvent = nullptr;
+    }
+    clear();
+}
+
+// Draws one layer of a thing frame from the atlas, placed like ThingType::draw places an untrimmed frame.
+// Returns false without drawing anything when a sprite of the frame can not be packed, or when the painter
+// would issue one draw call per sprite where ThingType::draw issues one for the whole frame.
+bool SpriteAtlas::drawThing(ThingType *type, const Point& dest, float scaleFactor, int layer, int xPattern, int yPattern, int zPattern, int animationPhase)
+{
+    if (!type || (type->getSize().area() > 1 && !g_painter->canBatchTexturedRects()))
+        return false;
+
+    Size size = type->getSize();
+    const std::vector<int>& sprites = type->getSprites();
+    Point frameTopLeft = dest - (type->getDisplacement() + (size.toPoint() - Point(1, 1)) * Otc::TILE_PIXELS) * scaleFactor;
+    int spriteSize = Otc::TILE_PIXELS * scaleFactor;
+
+    // Resolve the whole frame first so a partially packed frame is never drawn
+    m_frameEntries.assign(size.area(), nullptr);
+    for (int h = 0; h < size.height(); ++h) {
+        for (int w = 0; w < size.width(); ++w) {
+            uint index = ((((((animationPhase % type->getAnimationPhases())
+                            * type->getNumPatternZ() + zPattern)
+                            * type->getNumPatternY() + yPattern)
+                            * type->getNumPatternX() + xPattern)
+                            * type->getLayers() + layer)
+                            * size.height() + h)
+                            * size.width() + w;
+            if (index >= sprites.size() || m_emptySprites.count(sprites[index]))
+                continue;
+
+            const Entry *entry = getEntry(sprites[index]);
+            if (!entry && !m_emptySprites.count(sprites[index]))
+                return false;
+            m_frameEntries[h * size.width() + w] = entry;
+        }
+    }
+
+    for (int h = 0; h < size.height(); ++h) {
+        for (int w = 0; w < size.width(); ++w) {
+            const Entry *entry = m_frameEntries[h * size.width() + w];
+            if (!entry)
+                continue;
+
+            Point spritePos = frameTopLeft + Point(size.width() - w - 1, size.height() - h - 1) * spriteSize;
+            g_painter->drawTexturedRect(Rect(spritePos, spriteSize, spriteSize), getPageTexture(entry->page), getCellRect(entry->cell));
+        }
+    }
+    return true;
+}
+
+// Draws a single sprite stretched over dest
+bool SpriteAtlas::drawSprite(int spriteId, const Rect& dest)
+{
+    const Entry *entry = getEntry(spriteId);
+    if (!entry)
+        return m_emptySprites.count(spriteId) > 0;
+
+    g_painter->drawTexturedRect(dest, getPageTexture(entry->page), getCellRect(entry->cell));
+    return true;
+}
+
+// Moves the sprites of the sparsest page into free cells of the other pages, a batch at a time
+void SpriteAtlas::defragment()
+{
+    int sparsest = -1;
+    int freeElsewhere = 0;
+    for (int i = 0; i < (int)m_pages.size(); ++i) {
+        if (!m_pages[i].image)
+            continue;
+        if (sparsest < 0 || m_pages[i].freeCells.size() > m_pages[sparsest].freeCells.size())
+            sparsest = i;
+    }
+    if (sparsest < 0)
+        return;
+
+    for (int i = 0; i < (int)m_pages.size(); ++i) {
+        if (i != sparsest && m_pages[i].image)
+            freeElsewhere += m_pages[i].freeCells.size();
+    }
+
+    // Only worth it when the whole page fits elsewhere, otherwise sprites would just shuffle around
+    int liveCells = CELLS_PER_PAGE - m_pages[sparsest].freeCells.size();
+    if (liveCells > freeElsewhere)
+        return;
+
+    int moved = 0;
+    for (auto& pair : m_entries) {
+        Entry& entry = pair.second;
+        if (entry.page != sparsest)
+            continue;
+        if (moved++ == DEFRAG_BATCH)
+            break;
+
+        int page, cell;
+        if (!allocateCell(page, cell, sparsest))
+            break;
+        copyCell(entry.page, entry.cell, page, cell);
+        releaseCell(entry.page, entry.cell);
+        entry.page = page;
+        entry.cell = cell;
+    }
+}
+
+// Drops every sprite and atlas page
+void SpriteAtlas::clear()
+{
+    m_pages.clear();
+    m_entries.clear();
+    m_emptySprites.clear();
+    m_unpackableSprites.clear();
+    m_lru.clear();
+}
+
+// Counts the pages currently holding an image
+int SpriteAtlas::getPageCount()
+{
+    return std::count_if(m_pages.begin(), m_pages.end(), [](const Page& page) { return page.image != nullptr; });
+}
+
+// Gets the atlas cell of a sprite, decoding and packing it on a miss
+const SpriteAtlas::Entry *SpriteAtlas::getEntry(int spriteId)
+{
+    auto it = m_entries.find(spriteId);
+    if (it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+        m_hits++;
+        return &it->second;
+    }
+
+    if (m_emptySprites.count(spriteId) || m_unpackableSprites.count(spriteId))
+        return nullptr;
+
+    // Start the background defragmentation the first time a sprite is packed
+    if (!m_defragEvent)
+        m_defragEvent = g_dispatcher.cycleEvent([this] { defragment(); }, DEFRAG_INTERVAL);
+
+    m_misses++;
+    ImagePtr image = g_sprites.getSpriteImage(spriteId);
+    if (!image) {
+        m_emptySprites.insert(spriteId);
+        return nullptr;
+    }
+    if (image->getSize() != Size(CELL_SIZE, CELL_SIZE)) {
+        m_unpackableSprites.insert(spriteId);
+        return nullptr;
+    }
+
+    int page, cell;
+    if (!allocateCell(page, cell, -1))
+        return nullptr;
+
+    m_pages[page].image->blit(getCellRect(cell).topLeft(), image);
+    m_pages[page].dirtyCells.push_back(cell);
+    m_lru.push_front(spriteId);
+    return &(m_entries[spriteId] = Entry{page, cell, m_lru.begin()});
+}
+
+// Finds a free cell outside keepPage, opening a page or evicting the least recently used sprite when needed
+bool SpriteAtlas::allocateCell(int& page, int& cell, int keepPage)
+{
+    // Fill the fullest page first so sparse pages drain over time
+    page = -1;
+    for (int i = 0; i < (int)m_pages.size(); ++i) {
+        if (i == keepPage || !m_pages[i].image || m_pages[i].freeCells.empty())
+            continue;
+        if (page < 0 || m_pages[i].freeCells.size() < m_pages[page].freeCells.size())
+            page = i;
+    }
+
+    if (page < 0 && keepPage < 0) {
+        if (getPageCount() < m_maxPages) {
+            page = createPage();
+        } else if (!m_lru.empty()) {
+            auto entryIt = m_entries.find(m_lru.back());
+            page = entryIt->second.page;
+            releaseCell(page, entryIt->second.cell);
+            m_entries.erase(entryIt);
+            m_lru.pop_back();
+            m_evictions++;
+
+            // The evicted sprite may have been the last one of its page
+            if (!m_pages[page].image)
+                page = createPage();
+        }
+    }
+    if (page < 0)
+        return false;
+
+    cell = m_pages[page].freeCells.back();
+    m_pages[page].freeCells.pop_back();
+    return true;
+}
+
+// Returns a cell to its page, releasing the page once it holds no sprite
+void SpriteAtlas::releaseCell(int page, int cell)
+{
+    Page& atlasPage = m_pages[page];
+    atlasPage.freeCells.push_back(cell);
+    if ((int)atlasPage.freeCells.size() == CELLS_PER_PAGE && getPageCount() > 1)
+        atlasPage = Page();
+}
+
+// Opens a page, reusing the slot of a released one so page indexes stay stable
+int SpriteAtlas::createPage()
+{
+    int index = 0;
+    while (index < (int)m_pages.size() && m_pages[index].image)
+        ++index;
+    if (index == (int)m_pages.size())
+        m_pages.emplace_back();
+
+    Page& page = m_pages[index];
+    page.image = ImagePtr(new Image(Size(PAGE_SIZE, PAGE_SIZE)));
+    page.texture = nullptr;
+    page.dirtyCells.clear();
+    page.freeCells.clear();
+    for (int i = CELLS_PER_PAGE - 1; i >= 0; --i)
+        page.freeCells.push_back(i);
+    return index;
+}
+
+// Copies the pixels of one cell into another
+void SpriteAtlas::copyCell(int srcPage, int srcCell, int dstPage, int dstCell)
+{
+    Rect src = getCellRect(srcCell);
+    Rect dst = getCellRect(dstCell);
+    const uint8 *srcPixels = m_pages[srcPage].image->getPixelData();
+    uint8 *dstPixels = m_pages[dstPage].image->getPixelData();
+
+    for (int y = 0; y < CELL_SIZE; ++y)
+        memcpy(dstPixels + ((dst.top() + y) * PAGE_SIZE + dst.left()) * 4, srcPixels + ((src.top() + y) * PAGE_SIZE + src.left()) * 4, CELL_SIZE * 4);
+    m_pages[dstPage].dirtyCells.push_back(dstCell);
+}
+
+// Gets the texture of a page, uploading the cells packed since the last draw
+const TexturePtr& SpriteAtlas::getPageTexture(int page)
+{
+    Page& atlasPage = m_pages[page];
+    if (!atlasPage.texture) {
+        atlasPage.texture = TexturePtr(new Texture(atlasPage.image));
+        atlasPage.texture->setSmooth(false);
+        atlasPage.dirtyCells.clear();
+    } else if (!atlasPage.dirtyCells.empty()) {
+        // Binding the page behind the painter's back, so its queued draws go first and its binding is restored after
+        g_painter->flush();
+        GLint boundTexture = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+        glBindTexture(GL_TEXTURE_2D, atlasPage.texture->getId());
+        for (int cell : atlasPage.dirtyCells)
+            uploadCell(atlasPage, cell);
+        glBindTexture(GL_TEXTURE_2D, boundTexture);
+        atlasPage.dirtyCells.clear();
+    }
+    return atlasPage.texture;
+}
+
+// Uploads one cell of a page to its bound texture, staged because OpenGL ES 2 has no unpack row length
+void SpriteAtlas::uploadCell(Page& page, int cell)
+{
+    Rect rect = getCellRect(cell);
+    const uint8 *pixels = page.image->getPixelData();
+    m_cellPixels.resize(CELL_SIZE * CELL_SIZE * 4);
+    for (int y = 0; y < CELL_SIZE; ++y)
+        memcpy(&m_cellPixels[y * CELL_SIZE * 4], pixels + ((rect.top() + y) * PAGE_SIZE + rect.left()) * 4, CELL_SIZE * 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.left(), rect.top(), CELL_SIZE, CELL_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, m_cellPixels.data());
+}
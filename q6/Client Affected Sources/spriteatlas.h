@@ -0,0 +1,89 @@
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+#include <framework/graphics/declarations.h>
+
+/**
+ * Decoded thing sprites packed into large atlas pages, so consecutive
+ * sprite draws keep sampling the same texture instead of rebinding one
+ * texture per sprite. Every sprite takes one fixed size cell; cold sprites
+ * are evicted in least recently used order once the page limit is reached
+ * and a periodic pass moves the sprites of sparse pages into the free cells
+ * of fuller ones, releasing the pages it empties. Only the cells packed
+ * since the last draw are uploaded, and frames are only drawn from the
+ * atlas when the painter batches the per sprite quads into one draw call.
+ */
+class SpriteAtlas
+{
+public:
+    enum {
+        PAGE_SIZE = 1024,
+        CELL_SIZE = 32,
+        CELLS_PER_ROW = PAGE_SIZE / CELL_SIZE,
+        CELLS_PER_PAGE = CELLS_PER_ROW * CELLS_PER_ROW,
+        DEFAULT_MAX_PAGES = 16,
+        DEFRAG_INTERVAL = 2000,
+        DEFRAG_BATCH = 64
+    };
+
+    SpriteAtlas();
+
+    void terminate();
+
+    bool drawThing(ThingType *type, const Point& dest, float scaleFactor, int layer, int xPattern, int yPattern, int zPattern, int animationPhase);
+    bool drawSprite(int spriteId, const Rect& dest);
+    void defragment();
+    void clear();
+
+    void setMaxPages(int maxPages) { m_maxPages = std::max<int>(1, maxPages); clear(); }
+    int getMaxPages() { return m_maxPages; }
+    int getPageCount();
+    int getSpriteCount() { return m_entries.size(); }
+
+    int getHits() { return m_hits; }
+    int getMisses() { return m_misses; }
+    int getEvictions() { return m_evictions; }
+    void resetStats() { m_hits = m_misses = m_evictions = 0; }
+
+private:
+    struct Page {
+        ImagePtr image;
+        TexturePtr texture;
+        std::vector<int> freeCells;
+        std::vector<int> dirtyCells;
+    };
+    struct Entry {
+        int page;
+        int cell;
+        std::list<int>::iterator lruIt;
+    };
+
+    const Entry *getEntry(int spriteId);
+    bool allocateCell(int& page, int& cell, int keepPage);
+    void releaseCell(int page, int cell);
+    int createPage();
+    void copyCell(int srcPage, int srcCell, int dstPage, int dstCell);
+    const TexturePtr& getPageTexture(int page);
+    void uploadCell(Page& page, int cell);
+
+    static Rect getCellRect(int cell) { return Rect((cell % CELLS_PER_ROW) * CELL_SIZE, (cell / CELLS_PER_ROW) * CELL_SIZE, CELL_SIZE, CELL_SIZE); }
+
+    std::vector<Page> m_pages;
+    std::unordered_map<int, Entry> m_entries;
+    std::unordered_set<int> m_emptySprites;
+    std::unordered_set<int> m_unpackableSprites;
+    std::list<int> m_lru;
+    std::vector<const Entry*> m_frameEntries;
+    std::vector<uint8> m_cellPixels;
+    ScheduledEventPtr m_defragEvent;
+    int m_maxPages;
+    int m_hits;
+    int m_misses;
+    int m_evictions;
+};
+
+extern SpriteAtlas g_spriteAtlas;
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef STEPDURATION_H
+#define STEPDURATION_H
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Step duration formula of a creature. It takes every input as an argument
+ * and reads no client state, so the values memoized by
+ * Creature::getStepDuration can be checked against it in isolation.
+ * Speed formula coefficients are -1 when the server did not send them.
+ */
+inline int calculateStepDuration(int speed, int groundSpeed, bool newSpeedLaw, double formulaA, double formulaB, double formulaC,
+                                 int clientVersion, int serverBeat, bool diagonal)
+{
+    if (speed < 1) return 0;
+
+    // Adjust speed based on game features
+    int adjustedSpeed = newSpeedLaw ? speed * 2 : speed;
+    bool hasFormula = formulaA != -1 && formulaB != -1 && formulaC != -1;
+
+    // Calculate step interval based on ground speed and adjusted speed
+    int stepInterval = (groundSpeed > 0 && adjustedSpeed > 0) ? (1000 * groundSpeed) : 1000;
+    if (newSpeedLaw && hasFormula) {
+        int computedSpeed = std::max(1, (int)std::round(formulaA * log((adjustedSpeed / 2) + formulaB) + formulaC));
+        stepInterval /= computedSpeed;
+    } else {
+        stepInterval /= adjustedSpeed;
+    }
+
+    // Adjust step interval for client version and server beat
+    if (clientVersion >= 900)
+        stepInterval = (stepInterval / serverBeat) * serverBeat;
+
+    // Apply diagonal factor if necessary
+    float diagonalFactor = (clientVersion <= 810) ? 2.0f : 3.0f;
+    stepInterval = std::max(stepInterval, serverBeat);
+
+    // If the movement is diagonal, apply a diagonal factor to the step interval
+    if (diagonal)
+        stepInterval *= diagonalFactor;
+
+    return stepInterval;
+}
+
+#endif
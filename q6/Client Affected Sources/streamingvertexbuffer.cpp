@@ -0,0 +1,152 @@
+#include "streamingvertexbuffer.h"
+
+// Constructor for the StreamingVertexBuffer class, the GL buffer is created on the first write
+StreamingVertexBuffer::StreamingVertexBuffer()
+    : m_bufferId(0), m_mapped(nullptr), m_region(0), m_offset(0), m_created(false), m_persistentMapping(true)
+{
+#ifndef OPENGL_ES
+    m_fences.fill(nullptr);
+#endif
+}
+
+StreamingVertexBuffer::~StreamingVertexBuffer()
+{
+#ifndef OPENGL_ES
+    for(GLsync fence : m_fences) {
+        if(fence)
+            glDeleteSync(fence);
+    }
+#endif
+    if(m_bufferId) {
+        if(m_mapped) {
+            bind();
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            unbind();
+        }
+        glDeleteBuffers(1, &m_bufferId);
+    }
+}
+
+// Makes sure the next writes totalling size bytes land in the same storage, orphaning it if needed
+bool StreamingVertexBuffer::reserve(int size)
+{
+    if(!m_created)
+        create();
+    if(!m_bufferId)
+        return false;
+
+    int alignedSize = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if(m_mapped)
+        return m_offset + alignedSize <= REGION_SIZE;
+
+    if(alignedSize > CAPACITY)
+        return false;
+    if(m_offset + alignedSize > CAPACITY)
+        orphan();
+    return true;
+}
+
+// Copies data into the current frame region and returns its byte offset, -1 when it does not fit
+int StreamingVertexBuffer::write(const void *data, int size)
+{
+    if(!m_created)
+        create();
+    if(!m_bufferId)
+        return -1;
+
+    int alignedSize = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if(m_mapped) {
+        // A persistent region can not be orphaned, callers fall back to client arrays until the next frame
+        if(m_offset + alignedSize > REGION_SIZE)
+            return -1;
+
+        int offset = m_region * REGION_SIZE + m_offset;
+        memcpy(m_mapped + offset, data, size);
+        m_offset += alignedSize;
+        return offset;
+    }
+
+    if(alignedSize > CAPACITY)
+        return -1;
+    if(m_offset + alignedSize > CAPACITY)
+        orphan();
+
+    int offset = m_offset;
+    bind();
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+    m_offset += alignedSize;
+    return offset;
+}
+
+void StreamingVertexBuffer::bind()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_bufferId);
+}
+
+void StreamingVertexBuffer::unbind()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Fences the region written this frame and moves on to the next one
+void StreamingVertexBuffer::endFrame()
+{
+    if(!m_bufferId)
+        return;
+
+    if(!m_mapped) {
+        orphan();
+        return;
+    }
+
+#ifndef OPENGL_ES
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % FRAME_REGIONS;
+    m_offset = 0;
+
+    // Wait until the GPU is done with the draws that last used the region
+    GLsync& fence = m_fences[m_region];
+    if(fence) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+#endif
+}
+
+// Creates the buffer, persistently mapped when enabled and the driver supports buffer storage
+void StreamingVertexBuffer::create()
+{
+    m_created = true;
+    glGenBuffers(1, &m_bufferId);
+    if(!m_bufferId)
+        return;
+
+    bind();
+#ifndef OPENGL_ES
+    if(m_persistentMapping && GLEW_ARB_buffer_storage && GLEW_ARB_sync) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, CAPACITY, nullptr, flags);
+        m_mapped = static_cast<uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, CAPACITY, flags));
+
+        // Immutable storage can not be respecified, start over with a plain buffer
+        if(!m_mapped) {
+            unbind();
+            glDeleteBuffers(1, &m_bufferId);
+            glGenBuffers(1, &m_bufferId);
+            bind();
+        }
+    }
+#endif
+    if(!m_mapped)
+        glBufferData(GL_ARRAY_BUFFER, CAPACITY, nullptr, GL_STREAM_DRAW);
+    unbind();
+}
+
+// Hands the old storage to the driver so new writes never wait on pending draws
+void StreamingVertexBuffer::orphan()
+{
+    bind();
+    glBufferData(GL_ARRAY_BUFFER, CAPACITY, nullptr, GL_STREAM_DRAW);
+    m_offset = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef STREAMINGVERTEXBUFFER_H
+#define STREAMINGVERTEXBUFFER_H
+
+#include <framework/graphics/declarations.h>
+#include <framework/graphics/glutil.h>
+
+/**
+ * Ring buffer for vertex data that is drawn once, so immediate draws do
+ * not hand client side arrays to the driver. When persistent mapping is
+ * enabled and buffer storage is available, the buffer is persistently
+ * mapped and split in one region per frame in flight, each guarded by a
+ * fence. Regions are only recycled by endFrame, which MapView calls once
+ * per drawn frame; while no map is drawn a full region makes the painter
+ * fall back to client side arrays. Otherwise (and on OpenGL ES) writes go
+ * through glBufferSubData and the storage is orphaned once per frame or
+ * when it fills up.
+ */
+class StreamingVertexBuffer
+{
+public:
+    enum {
+        CAPACITY = 4 * 1024 * 1024,
+        FRAME_REGIONS = 3,
+        ALIGNMENT = 16,
+        REGION_SIZE = (CAPACITY / FRAME_REGIONS) & ~(ALIGNMENT - 1)
+    };
+
+    StreamingVertexBuffer();
+    ~StreamingVertexBuffer();
+
+    bool reserve(int size);
+    int write(const void *data, int size);
+    void bind();
+    static void unbind();
+    void endFrame();
+
+    void setPersistentMapping(bool enable) { m_persistentMapping = enable; }
+    bool isAvailable() { return m_bufferId != 0; }
+    bool isPersistent() { return m_mapped != nullptr; }
+
+private:
+    void create();
+    void orphan();
+
+    uint m_bufferId;
+    uint8 *m_mapped;
+    int m_region;
+    int m_offset;
+    bool m_created;
+    bool m_persistentMapping;
+#ifndef OPENGL_ES
+    std::array<GLsync, FRAME_REGIONS> m_fences;
+#endif
+};
+
+#endif
@@ -0,0 +1,155 @@
+// Golden checks of SoftwarePainter blending: one quad over a cleared target in every composition mode and blend equation.
+// Needs the framework headers and library, build it with the client sources, e.g.:
+// g++ -std=c++17 -I.. -I<framework include dir> softwarepainter_test.cpp ../softwarepainter.cpp ../painter.cpp -l<framework> -o softwarepainter_test
+#include "softwarepainter.h"
+#include "image.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+enum { TARGET_SIZE = 8 };
+
+const Color BACKGROUND(40, 80, 120, 200);
+const Color QUAD_COLOR(200, 100, 50, 128);
+const Rect QUAD_RECT(2, 2, 4, 4);
+
+const Painter::CompositionMode compositionModes[] = {
+    Painter::CompositionMode_Normal, Painter::CompositionMode_Multiply, Painter::CompositionMode_Add,
+    Painter::CompositionMode_Replace, Painter::CompositionMode_DestBlending, Painter::CompositionMode_Light
+};
+const char *compositionNames[] = { "normal", "multiply", "add", "replace", "destBlending", "light" };
+const Painter::BlendEquation blendEquations[] = { Painter::BlendEquation_Add, Painter::BlendEquation_Max };
+const char *blendNames[] = { "add", "max" };
+
+// GL blend factors, as PainterOGL::updateGlCompositionMode sets them up
+enum Factor { Zero, One, SrcColor, OneMinusSrcColor, SrcAlpha, OneMinusSrcAlpha, DstColor, DstAlpha, OneMinusDstAlpha };
+
+struct BlendFunc {
+    Factor srcColor, dstColor, srcAlpha, dstAlpha;
+};
+
+BlendFunc blendFunc(Painter::CompositionMode mode)
+{
+    switch (mode) {
+        case Painter::CompositionMode_Normal: return { SrcAlpha, OneMinusSrcAlpha, One, OneMinusSrcAlpha };
+        case Painter::CompositionMode_Multiply: return { DstColor, OneMinusSrcAlpha, DstColor, OneMinusSrcAlpha };
+        case Painter::CompositionMode_Add: return { OneMinusSrcColor, OneMinusSrcColor, OneMinusSrcColor, OneMinusSrcColor };
+        case Painter::CompositionMode_Replace: return { One, Zero, One, Zero };
+        case Painter::CompositionMode_DestBlending: return { OneMinusDstAlpha, DstAlpha, OneMinusDstAlpha, DstAlpha };
+        case Painter::CompositionMode_Light: return { Zero, SrcColor, Zero, SrcColor };
+    }
+    return { One, Zero, One, Zero };
+}
+
+float factorValue(Factor factor, const float *src, const float *dst, int channel)
+{
+    switch (factor) {
+        case Zero: return 0.0f;
+        case One: return 1.0f;
+        case SrcColor: return src[channel];
+        case OneMinusSrcColor: return 1.0f - src[channel];
+        case SrcAlpha: return src[3];
+        case OneMinusSrcAlpha: return 1.0f - src[3];
+        case DstColor: return dst[channel];
+        case DstAlpha: return dst[3];
+        case OneMinusDstAlpha: return 1.0f - dst[3];
+    }
+    return 0.0f;
+}
+
+// The pixel GL would leave where the quad covers the background
+void referencePixel(Painter::CompositionMode mode, Painter::BlendEquation equation, uint8 *out)
+{
+    const float src[4] = { QUAD_COLOR.rF(), QUAD_COLOR.gF(), QUAD_COLOR.bF(), QUAD_COLOR.aF() };
+    const float dst[4] = { BACKGROUND.rF(), BACKGROUND.gF(), BACKGROUND.bF(), BACKGROUND.aF() };
+    BlendFunc func = blendFunc(mode);
+    for (int i = 0; i < 4; ++i) {
+        float value;
+        if (equation == Painter::BlendEquation_Max)
+            value = std::max(src[i], dst[i]);
+        else if (i < 3)
+            value = src[i] * factorValue(func.srcColor, src, dst, i) + dst[i] * factorValue(func.dstColor, src, dst, i);
+        else
+            value = src[i] * factorValue(func.srcAlpha, src, dst, i) + dst[i] * factorValue(func.dstAlpha, src, dst, i);
+        out[i] = (uint8)std::round(std::max(0.0f, std::min(1.0f, value)) * 255.0f);
+    }
+}
+
+// Clears the target and draws the quad, the alpha channel is written so it takes part in the hash
+uint64 drawScene(SoftwarePainter& painter, Painter::CompositionMode mode, Painter::BlendEquation equation)
+{
+    painter.setAlphaWriting(true);
+    painter.clear(BACKGROUND);
+    painter.setCompositionMode(mode);
+    painter.setBlendEquation(equation);
+    painter.setColor(QUAD_COLOR);
+    painter.drawFilledRect(QUAD_RECT);
+    return painter.getImageHash();
+}
+
+bool pixelMatches(const uint8 *pixel, const uint8 *expected)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (std::abs(pixel[i] - expected[i]) > 1)
+            return false;
+    }
+    return true;
+}
+
+}
+
+int main()
+{
+    int checks = 0, failures = 0;
+    auto check = [&](bool ok, const char *what, int mode, int equation) {
+        checks++;
+        if (!ok) {
+            failures++;
+            std::printf("failed: %s, composition %s, blend %s\n", what, compositionNames[mode], blendNames[equation]);
+        }
+    };
+
+    std::map<uint64, std::vector<uint8>> pixelsByHash;
+    const uint8 background[4] = { BACKGROUND.r(), BACKGROUND.g(), BACKGROUND.b(), BACKGROUND.a() };
+    for (int mode = 0; mode < 6; ++mode) {
+        for (int equation = 0; equation < 2; ++equation) {
+            SoftwarePainter painter(Size(TARGET_SIZE, TARGET_SIZE));
+            uint64 hash = drawScene(painter, compositionModes[mode], blendEquations[equation]);
+
+            // Every covered pixel is blended, every other one is left alone
+            uint8 expected[4];
+            referencePixel(compositionModes[mode], blendEquations[equation], expected);
+            const uint8 *pixels = painter.getImage()->getPixelData();
+            bool inside = true, outside = true;
+            for (int y = 0; y < TARGET_SIZE; ++y) {
+                for (int x = 0; x < TARGET_SIZE; ++x) {
+                    const uint8 *pixel = pixels + (y * TARGET_SIZE + x) * 4;
+                    if (QUAD_RECT.contains(Point(x, y)))
+                        inside = inside && pixelMatches(pixel, expected);
+                    else
+                        outside = outside && pixelMatches(pixel, background);
+                }
+            }
+            check(inside, "covered pixels", mode, equation);
+            check(outside, "uncovered pixels", mode, equation);
+            check(painter.getFragmentCount() == (uint64)QUAD_RECT.area(), "fragment count", mode, equation);
+
+            // The same scene in a fresh painter hashes the same
+            SoftwarePainter again(Size(TARGET_SIZE, TARGET_SIZE));
+            check(drawScene(again, compositionModes[mode], blendEquations[equation]) == hash, "repeatable hash", mode, equation);
+
+            // Scenes share a hash only when they left the same pixels
+            std::vector<uint8> image(pixels, pixels + TARGET_SIZE * TARGET_SIZE * 4);
+            auto it = pixelsByHash.find(hash);
+            if (it != pixelsByHash.end())
+                check(it->second == image, "hash collision", mode, equation);
+            pixelsByHash[hash] = image;
+        }
+    }
+
+    std::printf("%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
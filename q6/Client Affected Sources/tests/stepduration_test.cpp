@@ -0,0 +1,101 @@
+// Checks calculateStepDuration against the step duration formula Creature::getStepDuration used before it was memoized.
+// Standalone, build and run with: g++ -std=c++17 -I.. stepduration_test.cpp -o stepduration_test && ./stepduration_test
+#include "stepduration.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// Inputs the former Creature::getStepDuration read from the creature, the target tile and g_game
+struct Inputs {
+    int speed;
+    int groundSpeed;
+    bool newSpeedLaw;
+    double speedFormula[3];
+    int clientVersion;
+    int serverBeat;
+    int lastStepDirection;
+    bool ignoreDiagonal;
+};
+
+enum { North, East, South, West, NorthEast, SouthEast, SouthWest, NorthWest };
+
+// The formula as it was, with the client state replaced by the inputs
+int referenceStepDuration(const Inputs& in)
+{
+    if (in.speed < 1) return 0;
+
+    int adjustedSpeed = in.newSpeedLaw ? in.speed * 2 : in.speed;
+
+    int groundSpeed = 150;
+    if (in.groundSpeed > 0)
+        groundSpeed = in.groundSpeed;
+
+    bool hasSpeedFormula = in.speedFormula[0] != -1 && in.speedFormula[1] != -1 && in.speedFormula[2] != -1;
+
+    int stepInterval = (groundSpeed > 0 && adjustedSpeed > 0) ? (1000 * groundSpeed) : 1000;
+    if (in.newSpeedLaw && hasSpeedFormula) {
+        int computedSpeed = std::max(1, (int)std::round(in.speedFormula[0] * log((adjustedSpeed / 2) + in.speedFormula[1]) + in.speedFormula[2]));
+        stepInterval /= computedSpeed;
+    } else {
+        stepInterval /= adjustedSpeed;
+    }
+
+    if (in.clientVersion >= 900)
+        stepInterval = (stepInterval / in.serverBeat) * in.serverBeat;
+
+    float diagonalFactor = (in.clientVersion <= 810) ? 2.0f : 3.0f;
+    stepInterval = std::max(stepInterval, in.serverBeat);
+
+    if (!in.ignoreDiagonal && (in.lastStepDirection == NorthWest || in.lastStepDirection == NorthEast ||
+                               in.lastStepDirection == SouthWest || in.lastStepDirection == SouthEast)) {
+        stepInterval *= diagonalFactor;
+    }
+
+    return stepInterval;
+}
+
+// Mirrors how Creature::getStepDuration feeds the memoized computation
+int memoizedStepDuration(const Inputs& in)
+{
+    int groundSpeed = in.groundSpeed > 0 ? in.groundSpeed : 150;
+    bool diagonal = !in.ignoreDiagonal && (in.lastStepDirection == NorthWest || in.lastStepDirection == NorthEast ||
+                                           in.lastStepDirection == SouthWest || in.lastStepDirection == SouthEast);
+    return calculateStepDuration(in.speed, groundSpeed, in.newSpeedLaw, in.speedFormula[0], in.speedFormula[1], in.speedFormula[2],
+                                 in.clientVersion, in.serverBeat, diagonal);
+}
+
+}
+
+int main()
+{
+    const std::vector<int> speeds = { -1, 0, 1, 2, 50, 100, 110, 220, 221, 440, 800, 1500, 3000, 65535 };
+    const std::vector<int> groundSpeeds = { 0, 10, 70, 90, 100, 120, 150, 200, 250, 500 };
+    const std::vector<std::vector<double>> speedFormulas = { { -1, -1, -1 }, { 857.36, 261.29, -4795.01 }, { 857.36, -1, -4795.01 }, { 1, 1, 1 } };
+    const std::vector<int> clientVersions = { 740, 810, 811, 854, 899, 900, 1098, 1100 };
+    const std::vector<int> serverBeats = { 1, 25, 50, 60, 100 };
+
+    int checks = 0, failures = 0;
+    for (int speed : speeds)
+    for (int groundSpeed : groundSpeeds)
+    for (bool newSpeedLaw : { false, true })
+    for (const auto& formula : speedFormulas)
+    for (int clientVersion : clientVersions)
+    for (int serverBeat : serverBeats)
+    for (int direction = North; direction <= NorthWest; ++direction)
+    for (bool ignoreDiagonal : { false, true }) {
+        Inputs in = { speed, groundSpeed, newSpeedLaw, { formula[0], formula[1], formula[2] }, clientVersion, serverBeat, direction, ignoreDiagonal };
+        int expected = referenceStepDuration(in);
+        int actual = memoizedStepDuration(in);
+        checks++;
+        if (expected != actual) {
+            if (failures++ < 10)
+                std::printf("mismatch: speed %d ground %d newLaw %d formula %g/%g/%g version %d beat %d direction %d ignoreDiagonal %d: expected %d, got %d\n",
+                            speed, groundSpeed, newSpeedLaw, formula[0], formula[1], formula[2], clientVersion, serverBeat, direction, ignoreDiagonal, expected, actual);
+        }
+    }
+
+    std::printf("%d step durations checked, %d mismatches\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include "textbatcher.h"
+
+#include <framework/graphics/bitmapfont.h>
+#include <framework/graphics/painter.h>
+
+// Global instance of the text batcher
+TextBatcher g_textBatcher;
+
+// Queues the glyph quads of a run at the given top left corner
+void TextBatcher::add(const GlyphRunPtr& run, const Point& topLeft, const Color& color)
+{
+    if (!run || run->glyphs.empty())
+        return;
+
+    CoordsBuffer& coords = getBatch(run->font->getTexture(), color).coords;
+    for (const auto& glyph : run->glyphs)
+        coords.addRect(glyph.first.translated(topLeft), glyph.second);
+}
+
+// Draws every queued quad and empties the batches
+void TextBatcher::flush()
+{
+    if (m_usedBatches == 0)
+        return;
+
+    for (size_t i = 0; i < m_usedBatches; ++i) {
+        Batch& batch = m_batches[i];
+        g_painter->setColor(batch.color);
+        g_painter->drawTextureCoords(batch.coords, batch.texture);
+        batch.coords.clear();
+        batch.texture = nullptr;
+    }
+    g_painter->resetColor();
+    m_usedBatches = 0;
+}
+
+// Finds the batch of a texture and color, there are only a handful per frame
+TextBatcher::Batch& TextBatcher::getBatch(const TexturePtr& texture, const Color& color)
+{
+    for (size_t i = 0; i < m_usedBatches; ++i) {
+        if (m_batches[i].texture == texture && m_batches[i].color == color)
+            return m_batches[i];
+    }
+
+    if (m_usedBatches == m_batches.size())
+        m_batches.emplace_back();
+
+    Batch& batch = m_batches[m_usedBatches++];
+    batch.texture = texture;
+    batch.color = color;
+    return batch;
+}
@@ -0,0 +1,35 @@
+#ifndef TEXTBATCHER_H
+#define TEXTBATCHER_H
+
+#include "glyphruncache.h"
+#include <framework/graphics/coordsbuffer.h>
+
+/**
+ * Collects the glyph runs drawn during a frame and submits them as quads
+ * from the font atlas, one draw call per font texture and color instead of
+ * one per text.
+ */
+class TextBatcher
+{
+public:
+    void add(const GlyphRunPtr& run, const Point& topLeft, const Color& color);
+    void flush();
+
+    bool isEmpty() { return m_usedBatches == 0; }
+
+private:
+    struct Batch {
+        TexturePtr texture;
+        Color color;
+        CoordsBuffer coords;
+    };
+
+    Batch& getBatch(const TexturePtr& texture, const Color& color);
+
+    std::vector<Batch> m_batches; // kept between frames so the coords buffers keep their capacity
+    size_t m_usedBatches = 0;
+};
+
+extern TextBatcher g_textBatcher;
+
+#endif
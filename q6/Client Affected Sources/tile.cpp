@@ -7,30 +7,66 @@
 #include "effect.h"
 #include "protocolgame.h"
 #include "lightview.h"
+#include "tilepool.h"
+#include "walkingcreatureindex.h"
+#include "translucentlightlayer.h"
+#include "walkanimator.h"
 #include <framework/graphics/fontmanager.h>
 
+// Zone flags in the order their colors take precedence
+static const tileflags_t zoneFlags[] = {
+    TILESTATE_HOUSE, TILESTATE_PROTECTIONZONE, TILESTATE_OPTIONALZONE, TILESTATE_HARDCOREZONE,
+    TILESTATE_REFRESH, TILESTATE_NOLOGOUT, TILESTATE_LAST
+};
+
+// Revision of tile flags, bumped on every change so zone overlays know when to rebuild
+uint32 Tile::m_flagsRevision = 0;
+
+// Revision of the grounds creatures are stepping onto, bumped when one of them changes so step durations are recomputed
+uint32 Tile::m_groundRevision = 0;
+
 // Constructor for the Tile class, initializes position and other attributes
 Tile::Tile(const Position& position)
     : m_position(position), m_drawElevation(0), m_minimapColor(0), m_flags(0) {}
 
-// Cleans the tile by removing all things from it
-void Tile::clean()
+// The light a tile casts on the floor below goes away with it, so cleaning the map also clears the light layer
+Tile::~Tile()
 {
-    while (!m_things.empty()) {
-        removeThing(m_things.front());
-    }
+    if (m_position.z != Otc::SEA_FLOOR) return;
+
+    Position downPos = m_position;
+    if (downPos.down())
+        g_translucentLight.setLight(downPos, false);
+}
+
+// Creates a tile in the pooled chunk of its map region, tiles without a valid position share a generic chunk
+TilePtr Tile::create(const Position& position)
+{
+    return TilePtr(new (position) Tile(position));
+}
+
+void* Tile::operator new(size_t size, const Position& position)
+{
+    assert(size == sizeof(Tile));
+    return g_tilePool.allocate(position);
+}
+
+void Tile::operator delete(void* ptr)
+{
+    g_tilePool.deallocate(ptr);
 }
 
-// Adds a walking creature to the tile
-void Tile::addWalkingCreature(const CreaturePtr& creature)
+void Tile::operator delete(void* ptr, const Position&)
 {
-    m_walkingCreatures.push_back(creature);
+    g_tilePool.deallocate(ptr);
 }
 
-// Removes a walking creature from the tile
-void Tile::removeWalkingCreature(const CreaturePtr& creature)
+// Cleans the tile by removing all things from it
+void Tile::clean()
 {
-    m_walkingCreatures.erase(std::remove(m_walkingCreatures.begin(), m_walkingCreatures.end(), creature), m_walkingCreatures.end());
+    while (!m_things.empty()) {
+        removeThing(m_things.front());
+    }
 }
 
 // Adds a thing to the tile at a specific stack position
@@ -69,6 +105,9 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
         }
     }
     
+    if (thing->isGround())
+        onGroundChange();
+
     // Set the position of the thing and trigger its appearance
     thing->setPosition(m_position);
     thing->onAppear();
@@ -80,37 +119,30 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
 }
 
 // Draws the tile and its contents on the screen
-void Tile::draw(const Point& dest, float scaleFactor, int drawFlags, std::vector<LocalEffect> localEffects, LightView *lightView)
+void Tile::draw(const Point& dest, float scaleFactor, int drawFlags, LightView *lightView)
+{
+    drawBottom(dest, scaleFactor, drawFlags, lightView);
+    drawTop(dest, scaleFactor, drawFlags, lightView);
+}
+
+// Draws the ground, borders, bottom things and items, which also determines the draw elevation
+void Tile::drawBottom(const Point& dest, float scaleFactor, int drawFlags, LightView *lightView)
 {
     bool animate = drawFlags & Otc::DrawAnimations;
     m_drawElevation = 0;
-    
-    // Define zone flags for special tile states
-    static const tileflags_t zoneFlags[] = {
-        TILESTATE_HOUSE, TILESTATE_PROTECTIONZONE, TILESTATE_OPTIONALZONE, TILESTATE_HARDCOREZONE,
-        TILESTATE_REFRESH, TILESTATE_NOLOGOUT, TILESTATE_LAST
-    };
+
+    // The ground may already have been drawn by MapView, as part of a merged run or of the zone ground pass
+    bool groundMerged = m_groundMerged;
+    m_groundMerged = false;
 
     // Lambda function to draw things within a specified range
     auto drawThings = [&](const auto& range) {
         for (const ThingPtr& thing : range) {
             if (!thing->isGround() && !thing->isGroundBorder() && !thing->isOnBottom()) break;
-
-            bool restoreColor = false;
-            if (g_map.showZones() && thing->isGround()) {
-                for (auto flag : zoneFlags) {
-                    if (hasFlag(flag) && g_map.showZone(flag)) {
-                        g_painter->setOpacity(g_map.getZoneOpacity());
-                        g_painter->setColor(g_map.getZoneColor(flag));
-                        restoreColor = true;
-                        break;
-                    }
-                }
-            }
+            if (groundMerged && thing->isGround()) continue;
 
             if (m_selected) g_painter->setColor(Color::teal);
             thing->draw(dest - m_drawElevation * scaleFactor, scaleFactor, animate, lightView);
-            if (restoreColor) g_painter->resetOpacity(), g_painter->resetColor();
             if (m_selected) g_painter->resetColor();
 
             m_drawElevation = std::min(m_drawElevation + thing->getElevation(), Otc::MAX_ELEVATION);
@@ -125,26 +157,15 @@ void Tile::draw(const Point& dest, float scaleFactor, int drawFlags, std::vector
     if (drawFlags & Otc::DrawItems) {
         drawThings(std::vector<ThingPtr>(m_things.rbegin(), m_things.rend()));
     }
+}
 
-    // Draw local effects such as afterimages
-    for (const LocalEffect& effect : localEffects) {
-        if (effect.m_type == LocalEffect::LocalEffectType_Afterimage) {
-            auto creature = effect.m_thing->static_self_cast<Creature>();
-            Point pos = dest + effect.m_data.afterimage.m_offset +
-                        Point((effect.m_data.afterimage.m_position.x - m_position.x) * Otc::TILE_PIXELS - m_drawElevation,
-                              (effect.m_data.afterimage.m_position.y - m_position.y) * Otc::TILE_PIXELS - m_drawElevation) * scaleFactor;
-            creature->drawAfterimage(pos, scaleFactor, effect.m_data.afterimage);
-        }
-    }
+// Draws standing creatures, effects and things on top, walking creatures are drawn by MapView in between
+void Tile::drawTop(const Point& dest, float scaleFactor, int drawFlags, LightView *lightView)
+{
+    bool animate = drawFlags & Otc::DrawAnimations;
 
     // Draw creatures on the tile
     if (drawFlags & Otc::DrawCreatures) {
-        for (const auto& creature : m_walkingCreatures) {
-            Point pos = dest + Point((creature->getPosition().x - m_position.x) * Otc::TILE_PIXELS - m_drawElevation,
-                                     (creature->getPosition().y - m_position.y) * Otc::TILE_PIXELS - m_drawElevation) * scaleFactor;
-            creature->draw(pos, scaleFactor, animate, lightView);
-        }
-
         for (auto it = m_things.rbegin(); it != m_things.rend(); ++it) {
             if (!(*it)->isCreature()) continue;
             auto creature = (*it)->static_self_cast<Creature>();
@@ -197,6 +218,8 @@ bool Tile::removeThing(ThingPtr thing)
                                      : removeFromList(m_things, thing);
 
     if (removed) {
+        if (thing->isGround())
+            onGroundChange();
         thing->onDisappear();
         if (thing->isTranslucent())
             checkTranslucentLight();
@@ -330,26 +353,12 @@ CreaturePtr Tile::getTopCreature()
         else if (thing->isCreature())
             return thing->static_self_cast<Creature>();
     }
-    if (!creature && !m_walkingCreatures.empty())
-        creature = m_walkingCreatures.back();
-
-    if (!creature) {
-        for (int xi = -1; xi <= 1; ++xi) {
-            for (int yi = -1; yi <= 1; ++yi) {
-                Position pos = m_position.translated(xi, yi);
-                if (pos == m_position)
-                    continue;
-
-                if (TilePtr tile = g_map.getTile(pos)) {
-                    for (const auto& c : tile->getCreatures()) {
-                        if (c->isWalking() && c->getLastStepFromPosition() == m_position && c->getStepProgress() < 0.75f) {
-                            creature = c;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    if (!creature)
+        creature = g_walkAnimator.getWalkingCreatureAt(m_position);
+
+    // Fall back to a creature that is still in the first part of a step away from this tile
+    if (!creature)
+        creature = g_walkingCreatures.getLeavingCreature(m_position, 0.75f);
     return creature;
 }
 
@@ -431,7 +440,6 @@ bool Tile::isFullyOpaque()
 // Checks if the tile is single dimension (1x1)
 bool Tile::isSingleDimension()
 {
-    if (!m_walkingCreatures.empty()) return false;
     return std::all_of(m_things.begin(), m_things.end(), [](const ThingPtr& thing) { return thing->getHeight() == 1 && thing->getWidth() == 1; });
 }
 
@@ -462,7 +470,34 @@ bool Tile::isEmpty()
 // Checks if the tile is drawable
 bool Tile::isDrawable()
 {
-    return !isEmpty() || !m_walkingCreatures.empty() || !m_effects.empty();
+    return !isEmpty() || !m_effects.empty();
+}
+
+// Checks if the tile is lit through a translucent thing on the floor above
+bool Tile::hasTranslucentLight()
+{
+    return g_translucentLight.hasLight(m_position);
+}
+
+// Gets the first zone flag of the tile that is currently shown, if any
+uint32 Tile::getShownZoneFlag()
+{
+    for (auto flag : zoneFlags) {
+        if (hasFlag(flag) && g_map.showZone(flag))
+            return flag;
+    }
+    return TILESTATE_NONE;
+}
+
+// Computes a signature of the zone display settings, changes whenever a zone color or toggle changes
+uint32 Tile::getZoneSettingsSignature()
+{
+    uint32 signature = 2166136261u;
+    for (auto flag : zoneFlags) {
+        signature = (signature ^ g_map.getZoneColor(flag).rgba()) * 16777619u;
+        signature = (signature ^ (g_map.showZone(flag) ? 1u : 0u)) * 16777619u;
+    }
+    return signature;
 }
 
 // Checks if the tile must hook east
@@ -495,7 +530,7 @@ bool Tile::limitsFloorsView(bool isFreeView)
 // Checks if the tile can be erased
 bool Tile::canErase()
 {
-    return isEmpty() && m_walkingCreatures.empty() && m_effects.empty() && m_flags == 0 && m_minimapColor == 0;
+    return isEmpty() && m_effects.empty() && m_flags == 0 && m_minimapColor == 0;
 }
 
 // Gets the elevation of the tile
@@ -510,7 +545,14 @@ bool Tile::hasElevation(int elevation)
     return getElevation() >= elevation;
 }
 
-// Checks and updates the translucent light state of the tile
+// Invalidates memoized step durations, only creatures stepping onto this tile read its ground speed
+void Tile::onGroundChange()
+{
+    if (g_walkingCreatures.hasCreatureEntering(m_position))
+        m_groundRevision++;
+}
+
+// Checks and updates the translucent light state of the position below the tile
 void Tile::checkTranslucentLight()
 {
     if (m_position.z != Otc::SEA_FLOOR) return;
@@ -518,15 +560,9 @@ void Tile::checkTranslucentLight()
     Position downPos = m_position;
     if (!downPos.down()) return;
 
-    auto tile = g_map.getOrCreateTile(downPos);
-    if (!tile) return;
-
     bool hasTranslucent = std::any_of(m_things.begin(), m_things.end(), [](const ThingPtr& thing) {
         return thing->isTranslucent() || thing->hasLensHelp();
     });
 
-    if (hasTranslucent)
-        tile->m_flags |= TILESTATE_TRANSLUECENT_LIGHT;
-    else
-        tile->m_flags &= ~TILESTATE_TRANSLUECENT_LIGHT;
-}
\ No newline at end of file
+    g_translucentLight.setLight(downPos, hasTranslucent);
+}
@@ -39,15 +39,21 @@ public:
     };
 
     Tile(const Position& position);
+    ~Tile();
 
-    void draw(const Point& dest, float scaleFactor, int drawFlags, std::vector<LocalEffect> localEffects, LightView *lightView = nullptr);
+    // Tiles are only created through create(), so every tile lands in the pool chunk of its region
+    static TilePtr create(const Position& position);
+    static void* operator new(size_t size, const Position& position);
+    static void operator delete(void* ptr);
+    static void operator delete(void* ptr, const Position& position);
+
+    void draw(const Point& dest, float scaleFactor, int drawFlags, LightView *lightView = nullptr);
+    void drawBottom(const Point& dest, float scaleFactor, int drawFlags, LightView *lightView = nullptr);
+    void drawTop(const Point& dest, float scaleFactor, int drawFlags, LightView *lightView = nullptr);
 
 public:
     void clean();
 
-    void addWalkingCreature(const CreaturePtr& creature);
-    void removeWalkingCreature(const CreaturePtr& creature);
-
     void addThing(const ThingPtr& thing, int stackPos);
     bool removeThing(ThingPtr thing);
     ThingPtr getThing(int stackPos);
@@ -66,7 +72,6 @@ public:
     int getDrawElevation() { return m_drawElevation; }
     std::vector<ItemPtr> getItems();
     std::vector<CreaturePtr> getCreatures();
-    const std::vector<CreaturePtr>& getWalkingCreatures() { return m_walkingCreatures; }
     const std::vector<ThingPtr>& getThings() { return m_things; }
     ItemPtr getGround();
     int getGroundSpeed();
@@ -81,7 +86,7 @@ public:
     bool isClickable();
     bool isEmpty();
     bool isDrawable();
-    bool hasTranslucentLight() { return m_flags & TILESTATE_TRANSLUECENT_LIGHT; }
+    bool hasTranslucentLight();
     bool mustHookSouth();
     bool mustHookEast();
     bool hasCreature();
@@ -91,11 +96,16 @@ public:
     bool hasElevation(int elevation = 1);
     void overwriteMinimapColor(uint8 color) { m_minimapColor = color; }
 
-    void remFlag(uint32 flag) { m_flags &= ~flag; }
-    void setFlag(uint32 flag) { m_flags |= flag; }
-    void setFlags(uint32 flags) { m_flags = flags; }
+    void remFlag(uint32 flag) { m_flags &= ~flag; m_flagsRevision++; }
+    void setFlag(uint32 flag) { m_flags |= flag; m_flagsRevision++; }
+    void setFlags(uint32 flags) { m_flags = flags; m_flagsRevision++; }
     bool hasFlag(uint32 flag) { return (m_flags & flag) == flag; }
     uint32 getFlags() { return m_flags; }
+    uint32 getShownZoneFlag();
+
+    static uint32 getFlagsRevision() { return m_flagsRevision; }
+    static uint32 getGroundRevision() { return m_groundRevision; }
+    static uint32 getZoneSettingsSignature();
 
     void setHouseId(uint32 hid) { m_houseId = hid; }
     uint32 getHouseId() { return m_houseId; }
@@ -105,12 +115,15 @@ public:
     void unselect() { m_selected = false; }
     bool isSelected() { return m_selected; }
 
+    void setGroundMerged(bool merged) { m_groundMerged = merged; }
+    bool isGroundMerged() { return m_groundMerged; }
+
     TilePtr asTile() { return static_self_cast<Tile>(); }
 
 private:
+    void onGroundChange();
     void checkTranslucentLight();
 
-    std::vector<CreaturePtr> m_walkingCreatures;
     std::vector<EffectPtr> m_effects; 
     std::vector<ThingPtr> m_things;
     Position m_position;
@@ -119,6 +132,10 @@ private:
     uint32 m_flags, m_houseId;
 
     stdext::boolean<false> m_selected;
+    stdext::boolean<false> m_groundMerged;
+
+    static uint32 m_flagsRevision;
+    static uint32 m_groundRevision;
 };
 
 #endif
\ No newline at end of file
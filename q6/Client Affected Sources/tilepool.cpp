@@ -0,0 +1,196 @@
+#include "tilepool.h"
+#include "tile.h"
+#include "map.h"
+#include <framework/core/eventdispatcher.h>
+
+// Global instance of the tile pool
+TilePool g_tilePool;
+
+// Key used for tiles created without a map position
+static const uint64 GENERIC_CHUNK_KEY = std::numeric_limits<uint64>::max();
+
+// Constructor for the TilePool class, slots are sized and aligned for a Tile
+TilePool::TilePool()
+    : m_slotSize((sizeof(Tile) + alignof(Tile) - 1) / alignof(Tile) * alignof(Tile)),
+      m_chunkCount(0), m_liveTiles(0), m_sweptTiles(0) {}
+
+// Cancels the sweep event, the dispatcher may still hold it after the pool is gone
+TilePool::~TilePool()
+{
+    terminate();
+}
+
+// Stops the periodic sweep, live chunks are released by their last tile
+void TilePool::terminate()
+{
+    if (m_sweepEvent) {
+        m_sweepEvent->cancel();
+        m_sweepEvent = nullptr;
+    }
+}
+
+// Allocates memory for a tile, preferring the slot of its position inside the region chunk
+void* TilePool::allocate(const Position& position)
+{
+    // Start the erasable tile sweep the first time a tile is created
+    if (!m_sweepEvent)
+        m_sweepEvent = g_dispatcher.cycleEvent([] { g_tilePool.sweep(); }, SWEEP_INTERVAL);
+
+    uint64 key = getChunkKey(position);
+    int preferredSlot = getPreferredSlot(position);
+
+    // Only chunks with a free slot are listed, a region rarely has more than one
+    Chunk *chunk = nullptr;
+    int slot = -1;
+    auto it = m_freeChunksByRegion.find(key);
+    if (it != m_freeChunksByRegion.end()) {
+        const std::vector<Chunk*>& freeChunks = it->second;
+        if (preferredSlot >= 0) {
+            for (Chunk *candidate : freeChunks) {
+                if (!candidate->used[preferredSlot]) {
+                    chunk = candidate;
+                    slot = preferredSlot;
+                    break;
+                }
+            }
+        }
+        if (!chunk) {
+            chunk = freeChunks.back();
+            for (slot = 0; chunk->used[slot]; ++slot);
+        }
+    }
+
+    // Open a new chunk when the region is full
+    if (!chunk) {
+        chunk = createChunk(key);
+        slot = preferredSlot >= 0 ? preferredSlot : 0;
+    }
+
+    chunk->used.set(slot);
+    if (chunk->used.all())
+        unlistFreeChunk(chunk);
+    m_liveTiles++;
+    return chunk->memory + slot * m_slotSize;
+}
+
+// Releases the slot of a tile and frees its chunk once it becomes empty
+void TilePool::deallocate(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    char *address = static_cast<char*>(ptr);
+    auto it = m_chunksByAddress.upper_bound(address);
+    assert(it != m_chunksByAddress.begin());
+    Chunk *chunk = (--it)->second;
+
+    int slot = (address - chunk->memory) / m_slotSize;
+    assert(slot >= 0 && slot < CHUNK_TILES && chunk->used[slot]);
+    chunk->used.reset(slot);
+    m_liveTiles--;
+
+    if (chunk->used.none())
+        destroyChunk(chunk);
+    else if (chunk->freeIndex < 0)
+        listFreeChunk(chunk);
+}
+
+// Removes erasable tiles the map is no longer aware of, on any floor
+void TilePool::sweep()
+{
+    // Nothing left to sweep once the map is gone, the next tile restarts the event
+    if (m_liveTiles == 0) {
+        terminate();
+        return;
+    }
+
+    // Collect the candidates first, erasing them frees slots and possibly whole chunks
+    std::vector<Position> erasable;
+    for (const auto& pair : m_chunksByAddress) {
+        Chunk *chunk = pair.second;
+        for (int i = 0; i < CHUNK_TILES && (int)erasable.size() < SWEEP_BATCH; ++i) {
+            if (!chunk->used[i])
+                continue;
+
+            Tile *tile = reinterpret_cast<Tile*>(chunk->memory + i * m_slotSize);
+            const Position& pos = tile->getPosition();
+            if (tile->canErase() && pos.isValid() && !g_map.isAwareOfPosition(pos))
+                erasable.push_back(pos);
+        }
+        if ((int)erasable.size() >= SWEEP_BATCH)
+            break;
+    }
+
+    for (const Position& pos : erasable) {
+        if (TilePtr tile = g_map.getTile(pos); tile && tile->canErase()) {
+            g_map.cleanTile(pos);
+            m_sweptTiles++;
+        }
+    }
+}
+
+// Computes the region key of a position, one chunk family per region and floor
+uint64 TilePool::getChunkKey(const Position& position)
+{
+    if (!position.isValid())
+        return GENERIC_CHUNK_KEY;
+
+    return ((uint64)(position.x / CHUNK_SIZE) << 32) | ((uint64)(position.y / CHUNK_SIZE) << 8) | (uint64)position.z;
+}
+
+// Gets the slot a position maps to inside its region chunk
+int TilePool::getPreferredSlot(const Position& position)
+{
+    if (!position.isValid())
+        return -1;
+
+    return (position.y % CHUNK_SIZE) * CHUNK_SIZE + (position.x % CHUNK_SIZE);
+}
+
+// Allocates the memory of a new chunk and registers it
+TilePool::Chunk *TilePool::createChunk(uint64 key)
+{
+    Chunk *chunk = new Chunk;
+    chunk->key = key;
+    chunk->memory = static_cast<char*>(::operator new(CHUNK_TILES * m_slotSize));
+    chunk->freeIndex = -1;
+    m_chunksByAddress[chunk->memory] = chunk;
+    listFreeChunk(chunk);
+    m_chunkCount++;
+    return chunk;
+}
+
+// Returns the memory of an empty chunk to the system
+void TilePool::destroyChunk(Chunk *chunk)
+{
+    if (chunk->freeIndex >= 0)
+        unlistFreeChunk(chunk);
+
+    m_chunksByAddress.erase(chunk->memory);
+    ::operator delete(chunk->memory);
+    delete chunk;
+    m_chunkCount--;
+}
+
+// Adds a chunk to the free list of its region
+void TilePool::listFreeChunk(Chunk *chunk)
+{
+    std::vector<Chunk*>& freeChunks = m_freeChunksByRegion[chunk->key];
+    chunk->freeIndex = freeChunks.size();
+    freeChunks.push_back(chunk);
+}
+
+// Removes a chunk from the free list of its region by swapping it with the last one
+void TilePool::unlistFreeChunk(Chunk *chunk)
+{
+    auto it = m_freeChunksByRegion.find(chunk->key);
+    std::vector<Chunk*>& freeChunks = it->second;
+    Chunk *last = freeChunks.back();
+    freeChunks[chunk->freeIndex] = last;
+    last->freeIndex = chunk->freeIndex;
+    freeChunks.pop_back();
+    chunk->freeIndex = -1;
+
+    if (freeChunks.empty())
+        m_freeChunksByRegion.erase(it);
+}
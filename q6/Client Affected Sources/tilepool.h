@@ -0,0 +1,69 @@
+#ifndef TILEPOOL_H
+#define TILEPOOL_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+#include <bitset>
+
+/**
+ * Chunked allocator for Tile objects. Every chunk holds the tiles of one
+ * CHUNK_SIZE x CHUNK_SIZE region of a floor, so tiles that are drawn and
+ * scanned together also sit next to each other in memory. Chunks are
+ * returned to the system as soon as their last tile dies, and a periodic
+ * sweep drops erasable tiles the player is not aware of from the map.
+ * Chunks with free slots are kept in a list per region, so allocating
+ * never scans the full chunks.
+ */
+class TilePool
+{
+public:
+    enum {
+        CHUNK_SIZE = 8,
+        CHUNK_TILES = CHUNK_SIZE * CHUNK_SIZE,
+        SWEEP_INTERVAL = 30000,
+        SWEEP_BATCH = 4096
+    };
+
+    TilePool();
+    ~TilePool();
+
+    void terminate();
+
+    void* allocate(const Position& position);
+    void deallocate(void* ptr);
+
+    void sweep();
+
+    int getChunkCount() { return m_chunkCount; }
+    int getLiveTileCount() { return m_liveTiles; }
+    int getSweptTileCount() { return m_sweptTiles; }
+    size_t getReservedBytes() { return (size_t)m_chunkCount * CHUNK_TILES * m_slotSize; }
+    size_t getUsedBytes() { return (size_t)m_liveTiles * m_slotSize; }
+
+private:
+    struct Chunk {
+        uint64 key;
+        char *memory;
+        std::bitset<CHUNK_TILES> used;
+        int freeIndex;
+    };
+
+    uint64 getChunkKey(const Position& position);
+    int getPreferredSlot(const Position& position);
+    Chunk *createChunk(uint64 key);
+    void destroyChunk(Chunk *chunk);
+    void listFreeChunk(Chunk *chunk);
+    void unlistFreeChunk(Chunk *chunk);
+
+    size_t m_slotSize;
+    int m_chunkCount;
+    int m_liveTiles;
+    int m_sweptTiles;
+    std::unordered_map<uint64, std::vector<Chunk*>> m_freeChunksByRegion;
+    std::map<char*, Chunk*> m_chunksByAddress;
+    ScheduledEventPtr m_sweepEvent;
+};
+
+extern TilePool g_tilePool;
+
+#endif
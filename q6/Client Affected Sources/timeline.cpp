@@ -0,0 +1,221 @@
+#include "timeline.h"
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+
+// Global instance of the timeline
+Timeline g_timeline;
+
+namespace {
+
+float lerp(float from, float to, float t) { return from + (to - from) * t; }
+PointF lerp(const PointF& from, const PointF& to, float t) { return from + (to - from) * t; }
+Color lerp(const Color& from, const Color& to, float t)
+{
+    return Color(lerp(from.rF(), to.rF(), t), lerp(from.gF(), to.gF(), t), lerp(from.bF(), to.bF(), t), lerp(from.aF(), to.aF(), t));
+}
+
+// Marks a tween as cancelled, it is removed on the next update
+template<typename T>
+bool cancelIn(std::vector<T>& tweens, uint32 id)
+{
+    for (T& tween : tweens) {
+        if (tween.id == id) {
+            tween.id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+bool findIn(const std::vector<T>& tweens, uint32 id)
+{
+    return std::any_of(tweens.begin(), tweens.end(), [id](const T& tween) { return tween.id == id; });
+}
+
+template<typename T>
+void removeCancelled(std::vector<T>& tweens)
+{
+    tweens.erase(std::remove_if(tweens.begin(), tweens.end(), [](const T& tween) { return tween.id == 0; }), tweens.end());
+}
+
+}
+
+// Stops the fallback update and drops every tween without finishing it
+void Timeline::terminate()
+{
+    if (m_fallbackEvent) {
+        m_fallbackEvent->cancel();
+        m_fallbackEvent = nullptr;
+    }
+    m_floatTweens.clear();
+    m_pointTweens.clear();
+    m_colorTweens.clear();
+    m_toggles.clear();
+    m_finished.clear();
+}
+
+uint32 Timeline::tweenFloat(float from, float to, int duration, Easing easing, const std::function<void(float)>& setter, const std::function<void()>& onFinish)
+{
+    uint32 id = nextId();
+    m_floatTweens.push_back(Tween<float>{id, g_clock.millis(), std::max<int>(duration, 1), easing, from, to, [setter](const float& value) { setter(value); }, onFinish});
+    schedule();
+    return id;
+}
+
+uint32 Timeline::tweenPoint(const PointF& from, const PointF& to, int duration, Easing easing, const std::function<void(const PointF&)>& setter, const std::function<void()>& onFinish)
+{
+    uint32 id = nextId();
+    m_pointTweens.push_back(Tween<PointF>{id, g_clock.millis(), std::max<int>(duration, 1), easing, from, to, setter, onFinish});
+    schedule();
+    return id;
+}
+
+uint32 Timeline::tweenColor(const Color& from, const Color& to, int duration, Easing easing, const std::function<void(const Color&)>& setter, const std::function<void()>& onFinish)
+{
+    uint32 id = nextId();
+    m_colorTweens.push_back(Tween<Color>{id, g_clock.millis(), std::max<int>(duration, 1), easing, from, to, setter, onFinish});
+    schedule();
+    return id;
+}
+
+uint32 Timeline::toggle(bool initial, int period, int duration, const std::function<void(bool)>& setter, const std::function<void()>& onFinish)
+{
+    uint32 id = nextId();
+    m_toggles.push_back(Toggle{id, g_clock.millis(), std::max<int>(period, 1), std::max<int>(duration, 0), 0, initial, setter, onFinish});
+    schedule();
+    return id;
+}
+
+void Timeline::cancel(uint32 id)
+{
+    if (id == 0)
+        return;
+
+    cancelIn(m_floatTweens, id) || cancelIn(m_pointTweens, id) || cancelIn(m_colorTweens, id) || cancelIn(m_toggles, id);
+}
+
+bool Timeline::isActive(uint32 id)
+{
+    return id != 0 && (findIn(m_floatTweens, id) || findIn(m_pointTweens, id) || findIn(m_colorTweens, id) || findIn(m_toggles, id));
+}
+
+// Advances every tween once, repeated calls within the same millisecond do nothing
+void Timeline::update()
+{
+    ticks_t now = g_clock.millis();
+    if (now == m_lastUpdate)
+        return;
+    m_lastUpdate = now;
+
+    // Setters may start or cancel tweens, so the arrays are only compacted after the pass
+    advance(m_floatTweens, now);
+    advance(m_pointTweens, now);
+    advance(m_colorTweens, now);
+    advanceToggles(now);
+
+    removeCancelled(m_floatTweens);
+    removeCancelled(m_pointTweens);
+    removeCancelled(m_colorTweens);
+    removeCancelled(m_toggles);
+
+    // Finish callbacks run last, they commonly chain the next tween
+    std::vector<std::function<void()>> finished;
+    finished.swap(m_finished);
+    for (const auto& onFinish : finished)
+        onFinish();
+
+    if (getTweenCount() == 0 && m_fallbackEvent) {
+        m_fallbackEvent->cancel();
+        m_fallbackEvent = nullptr;
+    }
+}
+
+float Timeline::ease(Easing easing, float progress)
+{
+    switch (easing) {
+        case Easing_InQuad:
+            return progress * progress;
+        case Easing_OutQuad:
+            return progress * (2.0f - progress);
+        case Easing_InOutQuad:
+            return progress < 0.5f ? 2.0f * progress * progress : -1.0f + (4.0f - 2.0f * progress) * progress;
+        case Easing_Arc:
+            return 4.0f * progress * (1.0f - progress);
+        default:
+            return progress;
+    }
+}
+
+uint32 Timeline::nextId()
+{
+    if (++m_lastId == 0)
+        ++m_lastId;
+    return m_lastId;
+}
+
+// Frames drive the timeline, the fallback keeps it running while nothing is drawn
+void Timeline::schedule()
+{
+    if (m_fallbackEvent)
+        return;
+
+    m_fallbackEvent = g_dispatcher.cycleEvent([this] {
+        if (g_clock.millis() - m_lastUpdate >= FALLBACK_INTERVAL)
+            update();
+    }, FALLBACK_INTERVAL);
+}
+
+template<typename T>
+void Timeline::advance(std::vector<Tween<T>>& tweens, ticks_t now)
+{
+    // Tweens added by setters are appended behind the current size and wait for the next update
+    size_t count = tweens.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (tweens[i].id == 0)
+            continue;
+
+        float progress = std::min<float>((now - tweens[i].startTime) / (float)tweens[i].duration, 1.0f);
+        T value = progress < 1.0f || tweens[i].easing == Easing_Arc ? lerp(tweens[i].from, tweens[i].to, ease(tweens[i].easing, progress)) : tweens[i].to;
+
+        // The setter may grow the array, so it is not called through a reference into it
+        auto setter = tweens[i].setter;
+        setter(value);
+
+        if (progress >= 1.0f && tweens[i].id != 0) {
+            tweens[i].id = 0;
+            if (tweens[i].onFinish)
+                m_finished.push_back(tweens[i].onFinish);
+        }
+    }
+}
+
+void Timeline::advanceToggles(ticks_t now)
+{
+    size_t count = m_toggles.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (m_toggles[i].id == 0)
+            continue;
+
+        ticks_t elapsed = now - m_toggles[i].startTime;
+        int dueFlips = elapsed / m_toggles[i].period;
+        if (m_toggles[i].duration > 0)
+            dueFlips = std::min<int>(dueFlips, m_toggles[i].duration / m_toggles[i].period);
+
+        // Only the latest state is written, skipped periods do not replay
+        if (dueFlips > m_toggles[i].flips) {
+            if ((dueFlips - m_toggles[i].flips) % 2)
+                m_toggles[i].value = !m_toggles[i].value;
+            m_toggles[i].flips = dueFlips;
+            auto setter = m_toggles[i].setter;
+            setter(m_toggles[i].value);
+        }
+
+        if (m_toggles[i].duration > 0 && elapsed >= m_toggles[i].duration && m_toggles[i].id != 0) {
+            m_toggles[i].id = 0;
+            if (m_toggles[i].onFinish)
+                m_finished.push_back(m_toggles[i].onFinish);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+
+/**
+ * Frame driven tween engine for cosmetic animations. Tweens of each value
+ * type live in their own contiguous array and are advanced together once
+ * per frame, writing the interpolated value through their setter. This
+ * replaces the dispatcher event that every jump, color fade, shield blink
+ * and timed square used to reschedule for itself, and is exposed to Lua
+ * as g_timeline for UI animations.
+ */
+class Timeline
+{
+public:
+    enum {
+        FALLBACK_INTERVAL = 16
+    };
+
+    enum Easing {
+        Easing_Linear = 0,
+        Easing_InQuad,
+        Easing_OutQuad,
+        Easing_InOutQuad,
+        Easing_Arc // goes from the start value to the end value and back, like a jump
+    };
+
+    void terminate();
+
+    uint32 tweenFloat(float from, float to, int duration, Easing easing, const std::function<void(float)>& setter, const std::function<void()>& onFinish = nullptr);
+    uint32 tweenPoint(const PointF& from, const PointF& to, int duration, Easing easing, const std::function<void(const PointF&)>& setter, const std::function<void()>& onFinish = nullptr);
+    uint32 tweenColor(const Color& from, const Color& to, int duration, Easing easing, const std::function<void(const Color&)>& setter, const std::function<void()>& onFinish = nullptr);
+    uint32 toggle(bool initial, int period, int duration, const std::function<void(bool)>& setter, const std::function<void()>& onFinish = nullptr);
+
+    void cancel(uint32 id);
+    bool isActive(uint32 id);
+    void update();
+
+    int getTweenCount() { return m_floatTweens.size() + m_pointTweens.size() + m_colorTweens.size() + m_toggles.size(); }
+
+    static float ease(Easing easing, float progress);
+
+private:
+    template<typename T>
+    struct Tween {
+        uint32 id;
+        ticks_t startTime;
+        int duration;
+        Easing easing;
+        T from;
+        T to;
+        std::function<void(const T&)> setter;
+        std::function<void()> onFinish;
+    };
+    struct Toggle {
+        uint32 id;
+        ticks_t startTime;
+        int period;
+        int duration; // 0 toggles until cancelled
+        int flips;
+        bool value;
+        std::function<void(bool)> setter;
+        std::function<void()> onFinish;
+    };
+
+    uint32 nextId();
+    void schedule();
+    template<typename T>
+    void advance(std::vector<Tween<T>>& tweens, ticks_t now);
+    void advanceToggles(ticks_t now);
+
+    std::vector<Tween<float>> m_floatTweens;
+    std::vector<Tween<PointF>> m_pointTweens;
+    std::vector<Tween<Color>> m_colorTweens;
+    std::vector<Toggle> m_toggles;
+    std::vector<std::function<void()>> m_finished;
+    uint32 m_lastId = 0;
+    ticks_t m_lastUpdate = 0;
+    ScheduledEventPtr m_fallbackEvent;
+};
+
+extern Timeline g_timeline;
+
+#endif
@@ -0,0 +1,58 @@
+#include "translucentlightlayer.h"
+
+// Global instance of the translucent light layer
+TranslucentLightLayer g_translucentLight;
+
+// Marks or unmarks a position as lit from the floor above
+void TranslucentLightLayer::setLight(const Position& pos, bool lit)
+{
+    if (!pos.isValid())
+        return;
+
+    if (lit)
+        m_floors[pos.z].insert(packPosition(pos));
+    else
+        m_floors[pos.z].erase(packPosition(pos));
+}
+
+// Checks if a position is lit from the floor above
+bool TranslucentLightLayer::hasLight(const Position& pos)
+{
+    if (!pos.isValid())
+        return false;
+
+    const auto& floor = m_floors[pos.z];
+    return !floor.empty() && floor.count(packPosition(pos)) > 0;
+}
+
+// Collects the lit positions of a floor inside an area given in map coordinates
+void TranslucentLightLayer::getLightsInArea(const Rect& area, int z, std::vector<Position>& lights)
+{
+    const auto& floor = m_floors[z];
+    if (floor.empty() || !area.isValid())
+        return;
+
+    // Probe the area cell by cell, unless the floor holds fewer lights than the area has cells
+    if ((size_t)area.width() * area.height() <= floor.size()) {
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            for (int x = area.left(); x <= area.right(); ++x) {
+                Position pos(x, y, z);
+                if (floor.count(packPosition(pos)))
+                    lights.push_back(pos);
+            }
+        }
+    } else {
+        for (uint32 key : floor) {
+            Position pos = unpackPosition(key, z);
+            if (area.contains(Point(pos.x, pos.y)))
+                lights.push_back(pos);
+        }
+    }
+}
+
+// Removes every light
+void TranslucentLightLayer::clear()
+{
+    for (auto& floor : m_floors)
+        floor.clear();
+}
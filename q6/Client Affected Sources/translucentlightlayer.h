@@ -0,0 +1,30 @@
+#ifndef TRANSLUCENTLIGHTLAYER_H
+#define TRANSLUCENTLIGHTLAYER_H
+
+#include "declarations.h"
+
+/**
+ * Sparse per floor set of positions lit through a translucent thing on
+ * the floor above (windows, glass). Kept outside the tiles so marking a
+ * light never has to create an otherwise empty tile. A light lives as
+ * long as the tile above that casts it.
+ */
+class TranslucentLightLayer
+{
+public:
+    void setLight(const Position& pos, bool lit);
+    bool hasLight(const Position& pos);
+    void getLightsInArea(const Rect& area, int z, std::vector<Position>& lights);
+
+    void clear();
+
+private:
+    static uint32 packPosition(const Position& pos) { return ((uint32)pos.x << 16) | (uint32)pos.y; }
+    static Position unpackPosition(uint32 key, int z) { return Position(key >> 16, key & 0xFFFF, z); }
+
+    std::array<std::unordered_set<uint32>, Otc::MAX_Z + 1> m_floors;
+};
+
+extern TranslucentLightLayer g_translucentLight;
+
+#endif
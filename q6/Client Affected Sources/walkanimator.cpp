@@ -0,0 +1,134 @@
+#include "walkanimator.h"
+#include "creature.h"
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+
+// Global instance of the walk animator
+WalkAnimator g_walkAnimator;
+
+// Stops the fallback update and drops every walk state
+void WalkAnimator::terminate()
+{
+    if (m_fallbackEvent) {
+        m_fallbackEvent->cancel();
+        m_fallbackEvent = nullptr;
+    }
+    m_states.clear();
+    m_events.clear();
+    m_walkingTiles.clear();
+}
+
+// Starts animating the walk of a creature, a creature is only kept once
+void WalkAnimator::addCreature(const CreaturePtr& creature)
+{
+    for (const WalkState& state : m_states) {
+        if (state.creature == creature)
+            return;
+    }
+    m_states.push_back(WalkState{creature});
+
+    // Frames drive the animation, the fallback keeps steps finishing while nothing is drawn
+    if (!m_fallbackEvent) {
+        m_fallbackEvent = g_dispatcher.cycleEvent([this] {
+            if (g_clock.millis() - m_lastUpdate >= FALLBACK_INTERVAL)
+                update();
+        }, FALLBACK_INTERVAL);
+    }
+}
+
+// Stops animating the walk of a creature
+void WalkAnimator::removeCreature(const CreaturePtr& creature)
+{
+    auto it = std::find_if(m_states.begin(), m_states.end(), [&](const WalkState& state) { return state.creature == creature; });
+    if (it == m_states.end())
+        return;
+
+    // The pass walks the array by index, so the state is only cleared and compacted once the pass is done
+    if (m_updating) {
+        it->creature = nullptr;
+        m_hasClearedStates = true;
+        return;
+    }
+
+    // Order does not matter, swap with the last state to keep the array compact
+    *it = std::move(m_states.back());
+    m_states.pop_back();
+}
+
+// Moves a creature between the tiles it walks over, an invalid position means no tile
+void WalkAnimator::moveWalkingTile(const CreaturePtr& creature, const Position& fromPos, const Position& toPos)
+{
+    if (fromPos.isValid()) {
+        auto it = m_walkingTiles.find(fromPos);
+        if (it != m_walkingTiles.end()) {
+            auto& creatures = it->second;
+            creatures.erase(std::remove(creatures.begin(), creatures.end(), creature), creatures.end());
+            if (creatures.empty())
+                m_walkingTiles.erase(it);
+        }
+    }
+
+    if (toPos.isValid())
+        m_walkingTiles[toPos].push_back(creature);
+}
+
+// Gets the last creature that is walking over a tile, the tile does not need to exist
+CreaturePtr WalkAnimator::getWalkingCreatureAt(const Position& tilePosition)
+{
+    auto it = m_walkingTiles.find(tilePosition);
+    if (it == m_walkingTiles.end())
+        return nullptr;
+    return it->second.back();
+}
+
+// Advances all walks once, repeated calls within the same millisecond do nothing
+void WalkAnimator::update()
+{
+    ticks_t now = g_clock.millis();
+    if (now == m_lastUpdate)
+        return;
+    m_lastUpdate = now;
+
+    // updateWalk may end the walk, removing the state, or start a new one, appending a state
+    m_updating = true;
+    for (size_t i = 0; i < m_states.size(); ++i) {
+        CreaturePtr creature = m_states[i].creature;
+        if (!creature)
+            continue;
+
+        creature->updateWalk();
+
+        if (creature->isWalking() && creature->calculateWalkingTilePosition() != creature->getWalkingTilePosition())
+            m_events.push_back(WalkEvent{WalkEvent_TileChanged, creature});
+    }
+    m_updating = false;
+
+    if (m_hasClearedStates) {
+        m_states.erase(std::remove_if(m_states.begin(), m_states.end(), [](const WalkState& state) { return !state.creature; }), m_states.end());
+        m_hasClearedStates = false;
+    }
+
+    dispatchEvents();
+
+    if (m_states.empty() && m_fallbackEvent) {
+        m_fallbackEvent->cancel();
+        m_fallbackEvent = nullptr;
+    }
+}
+
+// Applies the events collected during the last pass, they may add or remove walk states
+void WalkAnimator::dispatchEvents()
+{
+    for (size_t i = 0; i < m_events.size(); ++i) {
+        const CreaturePtr& creature = m_events[i].creature;
+        switch (m_events[i].type) {
+            case WalkEvent_TileChanged:
+                // An earlier event may have ended the walk meanwhile
+                if (creature->isWalking())
+                    creature->updateWalkingTile();
+                break;
+        }
+    }
+    m_events.clear();
+}
@@ -0,0 +1,63 @@
+#ifndef WALKANIMATOR_H
+#define WALKANIMATOR_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+
+/**
+ * Advances every walking creature once per frame from a shared clock.
+ * Walk offsets and animation phases are computed in one pass over a compact
+ * array of walk states, while walking tile transitions are collected as
+ * events and applied after the pass. Steps still end from updateWalk, so
+ * overrides such as the local player's pre-walk decide when a walk may
+ * terminate; states removed during the pass are only cleared and the array
+ * is compacted afterwards. This replaces the per-creature dispatcher event
+ * that used to fire every step duration / 32 ms. The tiles walked over are
+ * kept in a position-keyed map, so hovering a tile does not scan every walk.
+ */
+class WalkAnimator
+{
+public:
+    enum {
+        FALLBACK_INTERVAL = 50
+    };
+
+    enum WalkEventType {
+        WalkEvent_TileChanged
+    };
+
+    struct WalkState {
+        CreaturePtr creature;
+    };
+
+    void terminate();
+
+    void addCreature(const CreaturePtr& creature);
+    void removeCreature(const CreaturePtr& creature);
+    void update();
+
+    void moveWalkingTile(const CreaturePtr& creature, const Position& fromPos, const Position& toPos);
+    CreaturePtr getWalkingCreatureAt(const Position& tilePosition);
+    const std::vector<WalkState>& getWalkStates() { return m_states; }
+    int getWalkingCount() { return m_states.size(); }
+
+private:
+    struct WalkEvent {
+        WalkEventType type;
+        CreaturePtr creature;
+    };
+
+    void dispatchEvents();
+
+    std::vector<WalkState> m_states;
+    std::vector<WalkEvent> m_events;
+    std::unordered_map<Position, std::vector<CreaturePtr>, PositionHasher> m_walkingTiles;
+    ticks_t m_lastUpdate = 0;
+    bool m_updating = false;
+    bool m_hasClearedStates = false;
+    ScheduledEventPtr m_fallbackEvent;
+};
+
+extern WalkAnimator g_walkAnimator;
+
+#endif
@@ -0,0 +1,64 @@
+#include "walkingcreatureindex.h"
+#include "creature.h"
+
+// Global instance of the walking creature index
+WalkingCreatureIndex g_walkingCreatures;
+
+// Registers a creature that started a step away from a position
+void WalkingCreatureIndex::addLeavingCreature(const Position& fromPos, Creature *creature)
+{
+    m_leavingCreatures[fromPos].push_back(creature);
+}
+
+// Removes a creature from the position it was leaving, dropping empty buckets
+void WalkingCreatureIndex::removeLeavingCreature(const Position& fromPos, Creature *creature)
+{
+    auto it = m_leavingCreatures.find(fromPos);
+    if (it == m_leavingCreatures.end())
+        return;
+
+    auto& creatures = it->second;
+    creatures.erase(std::remove(creatures.begin(), creatures.end(), creature), creatures.end());
+    if (creatures.empty())
+        m_leavingCreatures.erase(it);
+}
+
+// Retrieves the last creature leaving a position that has not gone past the given step progress, skipping removed ones
+CreaturePtr WalkingCreatureIndex::getLeavingCreature(const Position& fromPos, float maxStepProgress)
+{
+    auto it = m_leavingCreatures.find(fromPos);
+    if (it == m_leavingCreatures.end())
+        return nullptr;
+
+    const auto& creatures = it->second;
+    for (auto rit = creatures.rbegin(); rit != creatures.rend(); ++rit) {
+        Creature *creature = *rit;
+        if (!creature->isRemoved() && creature->isWalking() && creature->getStepProgress() < maxStepProgress)
+            return creature->static_self_cast<Creature>();
+    }
+    return nullptr;
+}
+
+// Checks if a creature is mid-step onto a position, such a step always starts on one of its neighbours
+bool WalkingCreatureIndex::hasCreatureEntering(const Position& toPos)
+{
+    if (m_leavingCreatures.empty())
+        return false;
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            if (dx == 0 && dy == 0)
+                continue;
+
+            auto it = m_leavingCreatures.find(toPos.translated(dx, dy));
+            if (it == m_leavingCreatures.end())
+                continue;
+
+            for (Creature *creature : it->second) {
+                if (creature->getLastStepToPosition() == toPos)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
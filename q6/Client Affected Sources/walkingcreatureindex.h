@@ -0,0 +1,30 @@
+#ifndef WALKINGCREATUREINDEX_H
+#define WALKINGCREATUREINDEX_H
+
+#include "declarations.h"
+
+/**
+ * Map level index of walking creatures by the tile they are leaving.
+ * Creature::walk registers a step and terminateWalk removes it, so
+ * resolving a creature that is mid-step away from a tile (mouse hover,
+ * clicks, attacks) is a single hash lookup without scanning neighbours.
+ * The index does not own the creatures, a creature drops its entry when
+ * it is destroyed and removed creatures are never returned.
+ */
+class WalkingCreatureIndex
+{
+public:
+    void addLeavingCreature(const Position& fromPos, Creature *creature);
+    void removeLeavingCreature(const Position& fromPos, Creature *creature);
+    CreaturePtr getLeavingCreature(const Position& fromPos, float maxStepProgress);
+    bool hasCreatureEntering(const Position& toPos);
+
+    void clear() { m_leavingCreatures.clear(); }
+
+private:
+    std::unordered_map<Position, std::vector<Creature*>, PositionHasher> m_leavingCreatures;
+};
+
+extern WalkingCreatureIndex g_walkingCreatures;
+
+#endif